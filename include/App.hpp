@@ -3,13 +3,21 @@
 #include "Window.hpp"
 #include "KeyboardInput.hpp"
 #include "Chip8/Chip8.hpp"
+#include "Chip8/Vip.hpp"
+#include "Chip8/Governor.hpp"
 #include "SmoothReal.hpp"
+#include "Clock.hpp"
+#include "TripleBuffer.hpp"
+#include "SpscQueue.hpp"
 
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
 
 #include <vector>
+#include <optional>
 #include <string_view>
+#include <atomic>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -21,36 +29,130 @@ namespace ks {
 
 		auto run() -> void;
 
+	private:
+		// What the main thread needs from the core to show a frame and play its sound.
+		struct Frame {
+			int width{ Chip8::DISPLAY_X };
+			int height{ Chip8::DISPLAY_Y };
+			bool lowLevel{};
+			// Plane bits of every pixel, the 1861 only has the first one.
+			std::array<std::array<uint8_t, Vip::DISPLAY_Y>, Chip8::HIGH_RES_DISPLAY_X> pixels{};
+			bool mega{};
+			std::vector<uint32_t> megaFrame;
+			uint64_t megaFrameCount{};
+			uint8_t screenAlpha{};
+			bool playSound{};
+			bool hasAudioPattern{};
+			std::array<uint8_t, 16> audioPattern{};
+			float audioPatternRate{};
+			std::vector<uint8_t> sample;
+			int sampleRate{};
+			bool sampleLoop{};
+			uint32_t sampleSerial{};
+			// Emulated time over host time.
+			float speed{ 1.0f };
+			double instructionsPerSecond{};
+		};
+		// What the emulation thread needs from the main thread, sent every frame.
+		struct Input {
+			uint16_t keys{};
+			float speed{ 1.0f };
+			// A ROM the main thread has read, or the VIP's memory image in the low level mode. It is
+			// swapped in before the next frame.
+			std::optional<std::vector<uint8_t>> program;
+		};
+
 	private:
 		auto handle_events() -> void;
 		auto input(const float deltaTime) -> void;
-		auto update(const float deltaTime) -> void;
+		auto update(const int64_t elapsed) -> void;
 		auto render() -> void;
 	
 	private:
+		// Reads the ROM for the emulation thread, which loads it with the next input.
 		auto reload() -> void;
+		// Emulation thread.
+		auto emulate(const std::stop_token stop) -> void;
+		auto load(const std::vector<uint8_t>& program) -> void;
+		auto step(const int64_t elapsed) -> void;
+		auto run_frame() -> void;
+		auto publish() -> void;
+		// Stops the emulation thread between two steps and waits until it did, after that the core
+		// belongs to the main thread until resume. Only the pause menu needs that.
+		auto park() -> void;
+		auto resume() -> void;
+		auto read_keypad() const -> uint16_t;
+		auto get_display_width() const -> int {
+			return m_lowLevel ? Vip::DISPLAY_X : m_chip8.get_display_width();
+		}
+		auto get_display_height() const -> int {
+			return m_lowLevel ? Vip::DISPLAY_Y : m_chip8.get_display_height();
+		}
+		// Instructions, or machine cycles in the low level mode.
+		auto get_executed() const -> uint64_t {
+			return m_lowLevel ? m_vip.get_cycles() : m_chip8.get_executed_instructions();
+		}
+		auto is_mega_chip() const -> bool {
+			return !m_lowLevel && m_chip8.is_mega_chip();
+		}
 		auto play_sine_wave() -> void;
+		auto play_pattern(const Frame& frame) -> void;
+		auto play_sample(const Frame& frame) -> void;
 
 	private:
 		ks::Window m_window;
 		ks::KeyboardInput m_keyboard;
 		ks::Chip8 m_chip8;
+		ks::Vip m_vip;
 
 		SDL_AudioStream* m_audioStream{};
+		SDL_AudioStream* m_sampleStream{};
 		SDL_Texture* m_gameDisplay{};
+		SDL_Texture* m_megaDisplay{};
 		SDL_Event m_event{};
 
 		TTF_Font* m_font{};
 		TTF_TextEngine* m_textEngine{};
 		TTF_Text* m_text{};
+		TTF_Text* m_speedText{};
 
 		std::vector<std::vector<ks::SmoothFloat>> m_display;
+		// Palette index each pixel was last lit with.
+		std::vector<std::vector<uint8_t>> m_colors;
 		
 		fs::path m_romPath{};
+		// Read by reload, waiting for a free slot in the input queue.
+		std::optional<std::vector<uint8_t>> m_program;
 
+		// Above 1 while fast-forwarding, infinite without a cap.
 		float m_simulationSpeed{ 1.0f };
-		float m_accumulator{};
+		size_t m_fastForwardCap{};
+		ks::SmoothFloat m_speed;
+		TripleBuffer<Frame> m_frames;
+		SpscQueue<Input, 64> m_inputs;
+
+		// Owned by the emulation thread while it is not parked.
+		Input m_input;
+		Clock m_clock;
+		Governor m_governor;
+		float m_measureTime{};
+		float m_measuredSpeed{ 1.0f };
+		double m_instructionsPerSecond{};
+		uint64_t m_measuredInstructions{};
+		uint64_t m_coreTime{};
+
 		int m_currentSineSample{};
+		float m_patternPosition{};
+		uint64_t m_uploadedFrame{};
+		uint32_t m_playedSample{};
 		bool m_paused{};
+		bool m_changeKeypad{};
+		bool m_lowLevel{};
+		bool m_deterministic{};
+		bool m_adaptive{};
+
+		std::atomic<bool> m_parkRequested{};
+		std::atomic<bool> m_parked{};
+		std::jthread m_emulation;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "Chip8/Chip8.hpp"
+#include "Chip8/Semantics.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace ks {
+	// Machine state of a ROM that ran past its boot sequence, computed by boot() at compile time. Loading
+	// a ROM that has one starts from here instead of executing the same instructions again.
+	struct BootSnapshot {
+		CPU cpu{};
+		std::array<uint8_t, Chip8::CODE_SIZE> ram{};
+		Chip8::DisplayMemory display{};
+		uint64_t executed{};
+		// Of those, the ones spent in loops waiting for the delay timer.
+		uint64_t delayWait{};
+		// Timer phase in Chip8's units, at the default rate.
+		int64_t tick{};
+		bool playSound{};
+		// Quirks the boot ran with, the snapshot is only valid for them.
+		Chip8::Settings settings{};
+	};
+
+	// Ten seconds of CHIP-8, far below the loop limits compilers put on constant evaluation.
+	constexpr int BOOT_INSTRUCTIONS = 10 * Chip8::INSTRUCTIONS_PER_SECOND;
+
+	// Runs rom like Chip8 does after load_program, for at most limit instructions. It stops in front of
+	// the first instruction whose outcome depends on the player or the random generator, and in front
+	// of anything outside plain low resolution CHIP-8 or of memory beyond the first CODE_SIZE bytes.
+	// What the instructions do comes from semantics, only fetching, control flow and timing are here.
+	constexpr auto boot(const std::span<const uint8_t> rom, const Chip8::Settings settings = {}, const int limit = BOOT_INSTRUCTIONS) -> BootSnapshot {
+		constexpr int CODE_MASK = Chip8::CODE_SIZE - 1;
+
+		BootSnapshot state{};
+		state.settings = settings;
+		if (rom.size() > Chip8::CODE_SIZE - 0x200) {
+			return state;
+		}
+		for (size_t i = 0; i < Chip8::FONT.size(); i++) {
+			state.ram[Chip8::FONT_ADDRESS + i] = Chip8::FONT[i];
+		}
+		for (size_t i = 0; i < Chip8::BIG_FONT.size(); i++) {
+			state.ram[Chip8::BIG_FONT_ADDRESS + i] = Chip8::BIG_FONT[i];
+		}
+		for (size_t i = 0; i < rom.size(); i++) {
+			state.ram[0x200 + i] = rom[i];
+		}
+
+		CPU::Registers& registers = state.cpu.registers;
+		auto& V = registers.V;
+		registers.PC = 0x200;
+
+		auto decode_at = [&](const int address) -> Instruction {
+			return Chip8::decode(state.ram[address & CODE_MASK] << 8 | state.ram[(address + 1) & CODE_MASK]);
+		};
+		auto skip = [&](const bool condition) -> void {
+			if (!condition) return;
+			registers.PC += decode_at(registers.PC).op == Opcode::SET_I_LONG ? 4 : 2;
+		};
+		// I based accesses have to stay below CODE_SIZE, Chip8 has more memory behind it.
+		auto fits = [&](const int length) -> bool {
+			return registers.I + length <= Chip8::CODE_SIZE;
+		};
+
+		while (state.executed < static_cast<uint64_t>(limit)) {
+			const uint16_t pc = registers.PC;
+			const Instruction instruction = decode_at(pc);
+			const int x = instruction.vx;
+			const int y = instruction.vy;
+			registers.PC = (pc + 2) & 0xFFF;
+
+			bool supported = 1;
+			switch (instruction.op) {
+				using enum Opcode;
+			case NOP:
+				break;
+			case CLEAR:
+				state.display = {};
+				break;
+			case RET:
+				registers.PC = state.cpu.stack.pop();
+				break;
+			case JP:
+				registers.PC = instruction.address;
+				break;
+			case CALL:
+				state.cpu.stack.push(registers.PC);
+				registers.PC = instruction.address;
+				break;
+			case SKIP_VX_EQ_NN:
+				skip(semantics::skip_taken<SKIP_VX_EQ_NN>(registers, instruction));
+				break;
+			case SKIP_VX_NEQ_NN:
+				skip(semantics::skip_taken<SKIP_VX_NEQ_NN>(registers, instruction));
+				break;
+			case SKIP_VX_EQ_VY:
+				skip(semantics::skip_taken<SKIP_VX_EQ_VY>(registers, instruction));
+				break;
+			case SKIP_VX_NEQ_VY:
+				skip(semantics::skip_taken<SKIP_VX_NEQ_VY>(registers, instruction));
+				break;
+			case VX_SET:
+				V[x] = instruction.literal;
+				break;
+			case VX_ADD:
+				V[x] += instruction.literal;
+				break;
+			case SET_VX_TO_VY:
+				V[x] = V[y];
+				break;
+			case OR_VX_WITH_VY:
+				V[x] |= V[y];
+				break;
+			case AND_VX_WITH_VY:
+				V[x] &= V[y];
+				break;
+			case XOR_VX_WITH_VY:
+				V[x] ^= V[y];
+				break;
+			case ADD_VY_TO_VX:
+				semantics::add_vy_to_vx(registers, x, y);
+				break;
+			case SUB_VY_FROM_VX:
+				semantics::sub_vy_from_vx(registers, x, y);
+				break;
+			case SUB_VX_FROM_VY:
+				semantics::sub_vx_from_vy(registers, x, y);
+				break;
+			case SR_VX_BY_VY:
+				if (settings.putVYintoVXbeforeShift) semantics::shift_right<1>(registers, x, y);
+				else semantics::shift_right<0>(registers, x, y);
+				break;
+			case SL_VX_BY_VY:
+				if (settings.putVYintoVXbeforeShift) semantics::shift_left<1>(registers, x, y);
+				else semantics::shift_left<0>(registers, x, y);
+				break;
+			case SET_I:
+				registers.I = instruction.address;
+				registers.bank = 0;
+				break;
+			case JR:
+				registers.PC = instruction.address + V[settings.useVXinsteadOfV0 ? x : 0];
+				break;
+			case DRAW: {
+				// Outside the vertical blank the draw waits, one instruction at a time like Chip8 counts it.
+				if (settings.displayWait && state.tick >= Chip8::TIMER_FREQUENCY) {
+					registers.PC = pc;
+					break;
+				}
+				const bool large = (instruction.literal & 0xF) == 0 && settings.largeSprites;
+				const int rows = large ? 16 : instruction.literal & 0xF;
+				if (!fits(large ? 32 : rows)) {
+					supported = 0;
+					break;
+				}
+				const int left = V[x] & (Chip8::DISPLAY_X - 1);
+				const int top = V[y] & (Chip8::DISPLAY_Y - 1);
+				const uint8_t* sprite = state.ram.data() + registers.I;
+				const uint64_t collision = settings.clipping
+					? semantics::draw_sprite<1>(state.display, sprite, left, top, rows, large, 0)
+					: semantics::draw_sprite<0>(state.display, sprite, left, top, rows, large, 0);
+				V[0xF] = collision != 0;
+				break;
+			}
+			case SET_VX_TO_DELAY:
+				V[x] = registers.delay;
+				if (semantics::is_delay_wait(pc, instruction, decode_at(pc + 2), decode_at(pc + 4))) {
+					state.delayWait += semantics::delay_wait_round(V[x], decode_at(pc + 2));
+				}
+				break;
+			case SET_DELAY_TO_VX:
+				registers.delay = V[x];
+				break;
+			case SET_SOUND_TO_VX:
+				registers.sound = V[x];
+				break;
+			case ADD_VX_TO_I:
+				semantics::add_vx_to_i(registers, x);
+				break;
+			case SET_I_TO_HEX_CHARACTER:
+				semantics::set_i_to_hex_character(registers, x);
+				break;
+			case BCD_VX: {
+				if (!fits(3)) {
+					supported = 0;
+					break;
+				}
+				const std::array<uint8_t, 3> digits = semantics::bcd(V[x]);
+				for (int i = 0; i < 3; i++) {
+					state.ram[registers.I + i] = digits[i];
+				}
+				break;
+			}
+			case SAVE_VX:
+			case LOAD_VX: {
+				if (!fits(x + 1)) {
+					supported = 0;
+					break;
+				}
+				const int address = registers.I;
+				auto write = [&](const int offset, const uint8_t value) -> void {
+					state.ram[address + offset] = value;
+				};
+				const uint8_t* source = state.ram.data() + address;
+				if (instruction.op == SAVE_VX) {
+					if (settings.changeValueOfI) semantics::save_registers<1>(registers, x, write);
+					else semantics::save_registers<0>(registers, x, write);
+				}
+				else {
+					if (settings.changeValueOfI) semantics::load_registers<1>(registers, x, source);
+					else semantics::load_registers<0>(registers, x, source);
+				}
+				break;
+			}
+			default:
+				// CXNN, EX9E, EXA1, FX0A and everything beyond CHIP-8 are left to the interpreter.
+				supported = 0;
+				break;
+			}
+			if (!supported) {
+				registers.PC = pc;
+				break;
+			}
+
+			state.executed++;
+			state.tick += Chip8::TIMER_FREQUENCY;
+			if (state.tick >= Chip8::INSTRUCTIONS_PER_SECOND) {
+				state.tick -= Chip8::INSTRUCTIONS_PER_SECOND;
+				semantics::count_down(registers, 1);
+				state.playSound = registers.sound != 0;
+			}
+		}
+		return state;
+	}
+
+	// Instruction semantics checked by the compiler, every build runs them. Chip8 executes the same
+	// functions, so these hold for it too.
+	static_assert(Chip8::decode(0x8AB4).op == Opcode::ADD_VY_TO_VX && Chip8::decode(0x8AB4).vx == 0xA && Chip8::decode(0x8AB4).vy == 0xB);
+	static_assert(Chip8::decode(0xF00A).op == Opcode::WAIT_FOR_KEYPRESS);
+	static_assert(Chip8::decode(0x5012).op == Opcode::SAVE_VX_TO_VY);
+	static_assert([] {
+		// 8XY4 carries into VF, 8XY5 borrows, boot stops in front of FX0A.
+		constexpr std::array<uint8_t, 10> ROM{ 0x60, 0xFF, 0x61, 0x02, 0x80, 0x14, 0x82, 0x15, 0xF0, 0x0A };
+		const BootSnapshot state = boot(ROM);
+		const auto& V = state.cpu.registers.V;
+		return V[0] == 0x01 && V[2] == 0xFE && V[0xF] == 0 && state.executed == 4 && state.cpu.registers.PC == 0x208;
+		}());
+	static_assert([] {
+		// The delay timer counts down at TIMER_FREQUENCY.
+		constexpr int INSTRUCTIONS_PER_TICK = Chip8::INSTRUCTIONS_PER_SECOND / Chip8::TIMER_FREQUENCY;
+		constexpr std::array<uint8_t, 4> ROM{ 0x60, 0x02, 0xF0, 0x15 };
+		const BootSnapshot once = boot(ROM, {}, INSTRUCTIONS_PER_TICK);
+		const BootSnapshot twice = boot(ROM, {}, INSTRUCTIONS_PER_TICK * 2);
+		return once.cpu.registers.delay == 1 && twice.cpu.registers.delay == 0 && twice.executed == INSTRUCTIONS_PER_TICK * 2;
+		}());
+	static_assert([] {
+		// 00E0, ANNN, DXYN with the font: a zero at the top left, drawn twice it collides and is gone.
+		constexpr std::array<uint8_t, 8> ROM{ 0x00, 0xE0, 0xF0, 0x29, 0xD0, 0x05, 0xD0, 0x05 };
+		const BootSnapshot once = boot(ROM, {}, 3);
+		const BootSnapshot twice = boot(ROM, {}, 4);
+		return once.display[0][0] >> 60 == 0xF && once.cpu.registers.V[0xF] == 0 && twice.display[0][0] == 0 && twice.cpu.registers.V[0xF] == 1;
+		}());
+	static_assert([] {
+		// FX1E sets VF when I leaves the 12 bit range, not when it is already past it.
+		CPU::Registers leaving{ .V{ 1 }, .I = 0xFFF };
+		semantics::add_vx_to_i(leaving, 0);
+		CPU::Registers past{ .V{ 1 }, .I = 0x1000 };
+		semantics::add_vx_to_i(past, 0);
+		return leaving.I == 0x1000 && leaving.V[0xF] == 1 && past.I == 0x1001 && past.V[0xF] == 0;
+		}());
+	static_assert([] {
+		// With the display wait, a DXYN after FX29 waits for the next tick before it draws.
+		constexpr int INSTRUCTIONS_PER_TICK = Chip8::INSTRUCTIONS_PER_SECOND / Chip8::TIMER_FREQUENCY;
+		constexpr std::array<uint8_t, 4> ROM{ 0xF0, 0x29, 0xD0, 0x05 };
+		Chip8::Settings settings{};
+		settings.displayWait = 1;
+		const BootSnapshot waiting = boot(ROM, settings, INSTRUCTIONS_PER_TICK);
+		const BootSnapshot drawn = boot(ROM, settings, INSTRUCTIONS_PER_TICK + 1);
+		return waiting.display[0][0] == 0 && waiting.cpu.registers.PC == 0x202 && drawn.display[0][0] >> 60 == 0xF;
+		}());
+}
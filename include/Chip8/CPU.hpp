@@ -4,38 +4,45 @@
 #include <cstdint>
 
 namespace ks {
-	struct CPU {
-		std::array<bool, 16> keys{};
-		int8_t key{ -1 };
-		bool halted{};
+	// Everything instructions touch besides memory and the display, packed into one cache line of its
+	// own, so instances running on different threads never write to a shared line.
+	struct alignas(64) CPU {
+		struct Registers {
+			std::array<uint8_t, 16> V{};
+			uint16_t PC{};
+			uint16_t I{};
+			// Bits 16-23 of I, only MEGA-CHIP's 01NN NNNN and FX1E set them.
+			uint8_t bank{};
+			uint8_t delay{};
+			uint8_t sound{};
+
+			constexpr auto set_register(const uint8_t index, const uint8_t value) -> void {
+				V[index] = value;
+			}
+			constexpr auto get_register(const uint8_t index) const -> uint8_t {
+				return V[index];
+			}
+		} registers;
 
 		struct Stack {
 			std::array<uint16_t, 16> memory{};
 			uint8_t sp{};
 
-			auto push(const uint16_t value) -> void {
+			constexpr auto push(const uint16_t value) -> void {
 				if (sp == 16) return;
 				memory[sp++] = value;
 			}
-			auto pop() -> uint16_t {
+			constexpr auto pop() -> uint16_t {
 				if (sp == 0) return 0;
 				return memory[--sp];
 			}
 		} stack;
 
-		struct Registers {
-			std::array<uint8_t, 16> V{};
-			uint16_t PC{};
-			uint16_t I{};
-			uint8_t delay{};
-			uint8_t sound{};
-
-			auto set_register(const uint8_t index, const uint8_t value) -> void {
-				V[index] = value;
-			}
-			auto get_register(const uint8_t index) -> uint8_t {
-				return V[index];
-			}
-		} registers;
+		// Bit N is set while key N is held.
+		uint16_t keys{};
+		// Key FX0A saw pressed and waits to be released.
+		int8_t key{ -1 };
+		bool halted{};
 	};
-}
\ No newline at end of file
+	static_assert(sizeof(CPU) == 64, "CPU has to fit in one cache line");
+}
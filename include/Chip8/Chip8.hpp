@@ -2,28 +2,127 @@
 
 #include "Chip8/CPU.hpp"
 #include "Chip8/Instruction.hpp"
-#include "KeyboardInput.hpp"
+#include "Chip8/Jit.hpp"
+#include "Chip8/Memory.hpp"
+#include "Chip8/Recompiled.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
 
 namespace fs = std::filesystem;
 
 namespace ks {
 	class Chip8 {
 	public:
-		static constexpr int RAM_SIZE = 4096;
+		// XO-CHIP address space. I reaches all of it, but PC wraps at 12 bits like on CHIP-8, so only the
+		// first CODE_SIZE bytes can hold instructions and need to be predecoded. MEGA-CHIP ROMs are
+		// larger, memory grows to the next power of two that holds them, up to MAX_RAM_SIZE.
+		static constexpr int RAM_SIZE = 0x10000;
+		static constexpr int MAX_RAM_SIZE = 0x1000000;
+		static constexpr int CODE_SIZE = 0x1000;
+		// Memory is followed by a copy of its first RAM_GUARD bytes, so a read of up to that many bytes
+		// from any wrapped address can run straight through instead of wrapping every byte.
+		static constexpr int RAM_GUARD = 0x100;
 		static constexpr int DISPLAY_X = 64;
 		static constexpr int DISPLAY_Y = 32;
+		static constexpr int HIGH_RES_DISPLAY_X = 128;
+		static constexpr int HIGH_RES_DISPLAY_Y = 64;
+		// XO-CHIP bitplanes, a pixel's color is the plane bits put together.
+		static constexpr int PLANES = 4;
+		static constexpr int MEGA_DISPLAY_X = 256;
+		static constexpr int MEGA_DISPLAY_Y = 192;
+		// The timers run at 60 Hz and CHIP-8 at about 540 instructions a second by default.
+		static constexpr int TIMER_FREQUENCY = 60;
+		static constexpr int INSTRUCTIONS_PER_SECOND = 540;
 
-		using DisplayMemory = std::array<std::array<bool, DISPLAY_Y>, DISPLAY_X>;
+		static constexpr uint16_t FONT_ADDRESS = 0x50;
+		static constexpr std::array<uint8_t, 80> FONT{
+			0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+			0x20, 0x60, 0x20, 0x20, 0x70, // 1
+			0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+			0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+			0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+			0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+			0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+			0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+			0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+			0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+			0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+			0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+			0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+			0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+			0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+			0xF0, 0x80, 0xF0, 0x80, 0x80  // F
+		};
+		// SUPER-CHIP 8x10 digits for FX30.
+		static constexpr uint16_t BIG_FONT_ADDRESS = 0xA0;
+		static constexpr std::array<uint8_t, 160> BIG_FONT{
+			0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, // 0
+			0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // 1
+			0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, // 2
+			0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, // 3
+			0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, // 4
+			0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, // 5
+			0x3E, 0x7C, 0xC0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, // 6
+			0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, // 7
+			0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, // 8
+			0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C, // 9
+			0x18, 0x3C, 0x66, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+			0xFC, 0xFE, 0xC3, 0xC3, 0xFE, 0xFE, 0xC3, 0xC3, 0xFE, 0xFC, // B
+			0x3C, 0x7E, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0x7E, 0x3C, // C
+			0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+			0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xFF, 0xFF, // E
+			0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xC0, 0xC0  // F
+		};
+
+		// A row is two words, the most significant bit of the first one is the leftmost pixel. Low
+		// resolution only uses the first word of the first DISPLAY_Y rows.
+		using DisplayRow = std::array<uint64_t, 2>;
+		using DisplayMemory = std::array<DisplayRow, HIGH_RES_DISPLAY_Y>;
+
+		enum class Engine : uint8_t {
+			SWITCH,
+			THREADED,
+			JIT,
+			RECOMPILED,
+		};
+
+		enum class BlendMode : uint8_t {
+			NORMAL,
+			QUARTER,
+			HALF,
+			ADD,
+			MULTIPLY,
+		};
+
+		// MEGA-CHIP digitized sound, unsigned 8 bit mono samples.
+		struct Sample {
+			std::span<const uint8_t> data;
+			int rate{};
+			bool loop{};
+			// Changes every time 060N starts a sample, so the player knows to restart.
+			uint32_t serial{};
+		};
 
 		struct Settings {
 			bool putVYintoVXbeforeShift{};
 			bool useVXinsteadOfV0{};
 			bool changeValueOfI{};
 			bool clipping{ 1 };
-			bool changeKeypad{};
+			// DXYN waits for the vertical blank like on the COSMAC VIP, so low resolution ROMs draw at
+			// most once per frame.
+			bool displayWait{};
+			// DXY0 draws a 16x16 sprite in low resolution too, like on XO-CHIP. Plain CHIP-8 draws
+			// nothing there, high resolution always draws 16x16.
+			bool largeSprites{};
+
+			auto operator==(const Settings&) const -> bool = default;
 		};
 
 	public:
@@ -31,38 +130,436 @@ namespace ks {
 		~Chip8() = default;
 
 		auto load_program(const fs::path& path) -> bool;
+		// A ROM read by read_program, which does the file access and the size check up front so the
+		// instance can be handed the bytes on another thread.
+		auto load_program(const std::span<const uint8_t> rom) -> bool;
+		static auto read_program(const fs::path& path) -> std::optional<std::vector<uint8_t>>;
 		auto reset() -> void;
-		auto update(const ks::KeyboardInput& keyboard) -> void;
+		// Executes cycles instructions with the keypad latched for the whole batch, bit N is key N.
+		auto run_cycles(const int cycles, const uint16_t keypad) -> void;
+		// Executes up to the next timer tick, which is also the vertical blank.
+		auto run_frame(const uint16_t keypad) -> void;
 
 		auto should_play_sound() const -> bool {
 			return m_playSound;
 		}
+		auto is_halted() const -> bool {
+			return m_cpu.halted;
+		}
+		auto get_registers() const -> const CPU::Registers& {
+			return m_cpu.registers;
+		}
+		// FX0A at PC can not finish before the keypad changes.
+		auto is_waiting_for_key() const -> bool;
+		// Instructions left until the timers next count down. Timer ticks are also where the display is
+		// shown and sound starts or stops, so this is how far to run to reach the next event.
+		auto get_cycles_to_tick() const -> int {
+			return get_cycles_to_ticks(1);
+		}
+		// Lets ticks timer ticks pass without executing anything, for an instance that sat in FX0A.
+		// They count as executed like the FX0A repeats they stand for.
+		auto skip_ticks(const int ticks) -> void {
+			advance(get_cycles_to_ticks(ticks));
+		}
+		auto get_instructions_per_second() const -> int {
+			return m_instructionsPerSecond;
+		}
+		// Timers keep counting at exactly TIMER_FREQUENCY whatever the rate is.
+		auto set_instructions_per_second(const int rate) -> void;
 
-		auto get_display_memory() const -> const DisplayMemory& {
-			return m_displayMemory;
+		auto get_display_memory(const int plane) const -> const DisplayMemory& {
+			return m_displayMemory[plane];
+		}
+		auto get_display_row(const int plane, const int y) const -> const DisplayRow& {
+			return m_displayMemory[plane][y];
+		}
+		auto get_display_width() const -> int {
+			return m_highResolution ? HIGH_RES_DISPLAY_X : DISPLAY_X;
+		}
+		auto get_display_height() const -> int {
+			return m_highResolution ? HIGH_RES_DISPLAY_Y : DISPLAY_Y;
+		}
+		static auto is_pixel_set(const DisplayRow& row, const int x) -> bool {
+			return row[x >> 6] >> (63 - (x & 63)) & 1;
+		}
+		// XO-CHIP sound: while the sound timer runs, the 128 bit pattern loops at the pattern rate. ROMs
+		// that never load a pattern get the plain buzzer.
+		auto has_audio_pattern() const -> bool {
+			return m_hasAudioPattern;
+		}
+		auto get_audio_pattern() const -> const std::array<uint8_t, 16>& {
+			return m_audioPattern;
+		}
+		auto get_audio_pattern_rate() const -> float {
+			return 4000.0f * std::exp2((m_pitch - 64) / 48.0f);
+		}
+		// MEGA-CHIP draws into a back buffer of ARGB pixels and shows it on 00E0.
+		auto is_mega_chip() const -> bool {
+			return m_megaChip;
+		}
+		auto get_mega_frame() const -> std::span<const uint32_t> {
+			return m_megaFrame;
+		}
+		// Counts frames shown by 00E0, the picture only has to be uploaded when it changes.
+		auto get_mega_frame_count() const -> uint64_t {
+			return m_megaFrameCount;
+		}
+		auto get_screen_alpha() const -> uint8_t {
+			return m_screenAlpha;
+		}
+		auto get_sample() const -> const Sample& {
+			return m_sample;
 		}
 		auto get_settings() const -> const Settings& {
 			return m_settings;
 		}
-		auto set_settings(const Settings& settings) -> void {
-			m_settings = settings;
+		auto set_settings(const Settings& settings) -> void;
+		auto get_engine() const -> Engine {
+			return m_engine;
+		}
+		auto set_engine(const Engine engine) -> void {
+			m_engine = engine;
+		}
+		// Idle loops are skipped in one step by default. Turned off they are stepped through, which has to
+		// end in the same state.
+		auto set_idle_skipping(const bool enabled) -> void {
+			m_idleSkipping = enabled;
+		}
+		// With a seed, CXNN restarts the same sequence on every reset, so identical keypad input gives
+		// bit-identical runs. std::nullopt goes back to a fresh random seed per reset.
+		auto set_seed(const std::optional<uint64_t> seed) -> void;
+		auto get_executed_instructions() const -> uint64_t {
+			return m_executedInstructions;
+		}
+		// Of those, the ones spent in loops waiting for the delay timer.
+		auto get_delay_wait_instructions() const -> uint64_t {
+			return m_delayWaitInstructions;
+		}
+		auto get_draw_count() const -> uint64_t {
+			return m_draws;
+		}
+		auto has_recompiled_program() const -> bool {
+			return !m_recompiledBlocks.empty();
+		}
+		// Whether self-modifying code gave this instance decoded instructions of its own instead of the
+		// ones every instance of the ROM shares.
+		auto has_own_decoded() const -> bool {
+			return m_ownDecoded != nullptr;
+		}
+
+		// Constant expression, so programs can be decoded and run at compile time as well.
+		static constexpr auto decode(const uint16_t opcode) -> Instruction;
+
+		// The settings that change what instructions do. Every combination gets its own instantiation of
+		// the execution core, so handlers resolve them at compile time. Lockstep does the same.
+		struct Quirks {
+			bool putVYintoVXbeforeShift{};
+			bool useVXinsteadOfV0{};
+			bool changeValueOfI{};
+			bool clipping{};
+			bool displayWait{};
+			bool largeSprites{};
+		};
+
+		static constexpr size_t QUIRK_PROFILES = 64;
+
+		static constexpr auto quirk_profile(const Settings& settings) -> size_t {
+			return settings.putVYintoVXbeforeShift | settings.useVXinsteadOfV0 << 1 | settings.changeValueOfI << 2 | settings.clipping << 3 | settings.displayWait << 4 | settings.largeSprites << 5;
+		}
+		static constexpr auto quirks_of(const size_t profile) -> Quirks {
+			return { (profile & 1) != 0, (profile & 2) != 0, (profile & 4) != 0, (profile & 8) != 0, (profile & 16) != 0, (profile & 32) != 0 };
 		}
 
 	private:
-		auto fetch() -> uint16_t;
-		auto decode(const uint16_t opcode) -> Instruction;
-		auto execute(const Instruction instruction) -> void;
+		template<Quirks Q> auto run(const int cycles) -> void;
+
+		auto fetch() -> Instruction;
+		template<Quirks Q> auto execute(const Instruction instruction) -> void;
+		template<Quirks Q> auto execute_threaded(const Instruction instruction) -> void;
+		template<Quirks Q> auto execute_fused(const int budget) -> int;
+		template<Quirks Q> auto execute_jit(const int budget) -> int;
+		template<Quirks Q> auto execute_recompiled(const int budget) -> int;
+		auto advance(const int cycles) -> void;
+		auto get_cycles_to_ticks(const int ticks) const -> int {
+			const int64_t phase = static_cast<int64_t>(ticks) * m_instructionsPerSecond - m_tick;
+			return static_cast<int>(std::max<int64_t>((phase + TIMER_FREQUENCY - 1) / TIMER_FREQUENCY, 0));
+		}
+		template<Quirks Q> auto skip_idle(const int budget) -> int;
+
+		// Entry point for native code handing an instruction back to the interpreter.
+		template<Quirks Q> static auto interpret(void* context, const uint32_t opcode) -> void;
+
+		static auto predecode(std::span<Instruction, CODE_SIZE> decoded, const uint8_t* ram, const uint16_t address) -> void;
+		static auto fuse(std::span<Instruction, CODE_SIZE> decoded, const uint16_t address) -> void;
+		auto write_memory(const uint32_t address, const uint8_t value) -> void;
+		auto restore(const BootSnapshot& snapshot) -> void;
+		// Address of the byte offset bytes past I.
+		auto memory_address(const int offset) const -> uint32_t {
+			return ((m_cpu.registers.bank << 16 | m_cpu.registers.I) + offset) & m_ramMask;
+		}
+		// Up to RAM_GUARD bytes starting at a wrapped address.
+		auto read_burst(const uint32_t address) const -> const uint8_t* {
+			return m_RAM.data() + address;
+		}
+		auto skip() -> void;
+		auto draw_mega(const Instruction instruction) -> void;
+		auto blend(const uint32_t source, const uint32_t target) const -> uint32_t;
+		auto scroll_mega(const int dx, const int dy) -> void;
 
 	private:
-		std::array<uint8_t, RAM_SIZE> m_RAM{};
-		int32_t m_tick{};
-		bool m_releaseIt{};
-		bool m_released{};
-		bool m_playSound{};
+		using Handler = void (Chip8::*)(const Instruction);
+		using FusedHandler = int (Chip8::*)(const uint16_t address);
+		using Runner = void (Chip8::*)(const int cycles);
 
-		DisplayMemory m_displayMemory{};
+		auto fused_delay_wait(const uint16_t address) -> int;
+		auto fused_load_pair(const uint16_t address) -> int;
+		template<Quirks Q> auto fused_set_i_and_draw(const uint16_t address) -> int;
+		template<Quirks Q> auto fused_skip_jump(const uint16_t address) -> int;
 
+		auto op_unknown(const Instruction instruction) -> void;
+		auto op_nop(const Instruction instruction) -> void;
+		auto op_clear(const Instruction instruction) -> void;
+		auto op_ret(const Instruction instruction) -> void;
+		auto op_jp(const Instruction instruction) -> void;
+		auto op_call(const Instruction instruction) -> void;
+		auto op_skip_vx_eq_nn(const Instruction instruction) -> void;
+		auto op_skip_vx_neq_nn(const Instruction instruction) -> void;
+		auto op_skip_vx_eq_vy(const Instruction instruction) -> void;
+		auto op_vx_set(const Instruction instruction) -> void;
+		auto op_vx_add(const Instruction instruction) -> void;
+		auto op_set_vx_to_vy(const Instruction instruction) -> void;
+		auto op_or_vx_with_vy(const Instruction instruction) -> void;
+		auto op_and_vx_with_vy(const Instruction instruction) -> void;
+		auto op_xor_vx_with_vy(const Instruction instruction) -> void;
+		auto op_add_vy_to_vx(const Instruction instruction) -> void;
+		auto op_sub_vy_from_vx(const Instruction instruction) -> void;
+		template<Quirks Q> auto op_sr_vx_by_vy(const Instruction instruction) -> void;
+		auto op_sub_vx_from_vy(const Instruction instruction) -> void;
+		template<Quirks Q> auto op_sl_vx_by_vy(const Instruction instruction) -> void;
+		auto op_skip_vx_neq_vy(const Instruction instruction) -> void;
+		auto op_set_i(const Instruction instruction) -> void;
+		template<Quirks Q> auto op_jr(const Instruction instruction) -> void;
+		auto op_random(const Instruction instruction) -> void;
+		template<Quirks Q> auto op_draw(const Instruction instruction) -> void;
+		auto op_key_pressed(const Instruction instruction) -> void;
+		auto op_key_not_pressed(const Instruction instruction) -> void;
+		auto op_set_vx_to_delay(const Instruction instruction) -> void;
+		auto op_wait_for_keypress(const Instruction instruction) -> void;
+		auto op_set_delay_to_vx(const Instruction instruction) -> void;
+		auto op_set_sound_to_vx(const Instruction instruction) -> void;
+		auto op_add_vx_to_i(const Instruction instruction) -> void;
+		auto op_set_i_to_hex_character(const Instruction instruction) -> void;
+		auto op_bcd_vx(const Instruction instruction) -> void;
+		template<Quirks Q> auto op_save_vx(const Instruction instruction) -> void;
+		template<Quirks Q> auto op_load_vx(const Instruction instruction) -> void;
+		auto op_scroll_down(const Instruction instruction) -> void;
+		auto op_scroll_right(const Instruction instruction) -> void;
+		auto op_scroll_left(const Instruction instruction) -> void;
+		auto op_exit(const Instruction instruction) -> void;
+		auto op_low_res(const Instruction instruction) -> void;
+		auto op_high_res(const Instruction instruction) -> void;
+		auto op_set_i_to_big_character(const Instruction instruction) -> void;
+		auto op_save_flags(const Instruction instruction) -> void;
+		auto op_load_flags(const Instruction instruction) -> void;
+		auto op_set_i_long(const Instruction instruction) -> void;
+		auto op_select_planes(const Instruction instruction) -> void;
+		auto op_save_vx_to_vy(const Instruction instruction) -> void;
+		auto op_load_vx_to_vy(const Instruction instruction) -> void;
+		auto op_load_audio_pattern(const Instruction instruction) -> void;
+		auto op_set_pitch_to_vx(const Instruction instruction) -> void;
+		auto op_mega_off(const Instruction instruction) -> void;
+		auto op_mega_on(const Instruction instruction) -> void;
+		auto op_scroll_up(const Instruction instruction) -> void;
+		auto op_set_i_mega(const Instruction instruction) -> void;
+		auto op_load_palette(const Instruction instruction) -> void;
+		auto op_set_sprite_width(const Instruction instruction) -> void;
+		auto op_set_sprite_height(const Instruction instruction) -> void;
+		auto op_set_screen_alpha(const Instruction instruction) -> void;
+		auto op_play_sample(const Instruction instruction) -> void;
+		auto op_stop_sample(const Instruction instruction) -> void;
+		auto op_set_blend_mode(const Instruction instruction) -> void;
+		auto op_set_collision_color(const Instruction instruction) -> void;
+
+	private:
+		// Hot state first: the CPU fills the object's first cache line and what every batch of
+		// instructions reads follows it. Memory lives on the heap, the display and the MEGA-CHIP buffers
+		// come last.
 		CPU m_cpu;
+		Runner m_run{};
+		// Time since the last timer tick in 1 / (TIMER_FREQUENCY * rate) seconds: an instruction adds
+		// TIMER_FREQUENCY, a tick takes the rate. Integer all the way, so timers never drift.
+		int64_t m_tick{};
+		int32_t m_instructionsPerSecond{ INSTRUCTIONS_PER_SECOND };
+		bool m_playSound{};
+		Engine m_engine{};
+		bool m_idleSkipping{ 1 };
+		uint32_t m_ramMask{ RAM_SIZE - 1 };
+		uint64_t m_executedInstructions{};
+		uint64_t m_delayWaitInstructions{};
+		uint64_t m_draws{};
+		Memory m_RAM{ RAM_SIZE + RAM_GUARD };
+		// xoshiro128** state for CXNN.
+		std::array<uint32_t, 4> m_random{};
+		// Planes selected by FN01, drawing, clearing and scrolling only touch these.
+		uint8_t m_planes{ 1 };
+		bool m_highResolution{};
+		bool m_megaChip{};
 		Settings m_settings;
+		std::unique_ptr<Jit> m_jit;
+		// Ahead-of-time compiled block starting at every address, empty if the ROM was not recompiled.
+		std::vector<const RecompiledBlock*> m_recompiledBlocks;
+		// Decoded instruction starting at every address, kept in sync with m_RAM. It is the image's table
+		// until the first write into code, which gives the instance a copy of its own.
+		std::shared_ptr<const MemoryImage> m_image;
+		std::unique_ptr<std::array<Instruction, CODE_SIZE>> m_ownDecoded;
+		const Instruction* m_decoded{};
+
+		std::optional<uint64_t> m_seed;
+		// SUPER-CHIP flag registers, kept across resets like the HP-48 kept them.
+		std::array<uint8_t, 16> m_flags{};
+		std::array<uint8_t, 16> m_audioPattern{};
+		uint8_t m_pitch{ 64 };
+		bool m_hasAudioPattern{};
+		std::array<DisplayMemory, PLANES> m_displayMemory{};
+
+		// Palette index and color of every MEGA-CHIP pixel being drawn, and the last shown frame.
+		std::vector<uint8_t> m_megaIndices;
+		std::vector<uint32_t> m_megaPixels;
+		std::vector<uint32_t> m_megaFrame;
+		uint64_t m_megaFrameCount{};
+		std::array<uint32_t, 256> m_palette{};
+		int m_spriteWidth{};
+		int m_spriteHeight{};
+		uint8_t m_screenAlpha{ 0xFF };
+		BlendMode m_blendMode{};
+		uint8_t m_collisionColor{};
+		Sample m_sample;
 	};
+
+	constexpr auto Chip8::decode(const uint16_t opcode) -> Instruction {
+		const uint8_t n1 = (opcode >> 12) & 0xF;
+		const uint8_t n2 = (opcode >> 8) & 0xF;
+		const uint8_t n3 = (opcode >> 4) & 0xF;
+		const uint8_t n4 = (opcode) & 0xF;
+		const uint8_t n34 = opcode & 0xFF;
+
+		Instruction instruction;
+		instruction.type = static_cast<InstructionType>(n1);
+		instruction.vx = n2;
+		instruction.vy = n3;
+		instruction.address = opcode & 0x0FFF;
+
+		if (instruction.type == InstructionType::ZERO && n2 == 0) {
+			instruction.zeroType = static_cast<ZeroType>(n34);
+		}
+		else if (instruction.type == InstructionType::ARITHMETIC) {
+			instruction.arithmeticType = static_cast<ArithmeticType>(n4);
+		}
+		else if (instruction.type == InstructionType::MISC) {
+			instruction.miscType = static_cast<MiscType>(n34);
+		}
+		else if (instruction.type == InstructionType::KEY) {
+			instruction.keyType = static_cast<KeyType>(n34);
+		}
+		else if (instruction.type == InstructionType::SKIP_VX_NEQ_VY) {
+			instruction.rangeType = static_cast<RangeType>(n4);
+		}
+		else {
+			instruction.literal = n34;
+		}
+
+		instruction.op = [&]() -> Opcode {
+			switch (instruction.type) {
+				using enum InstructionType;
+			case ZERO:
+				switch (n2) {
+				case 0x0: break;
+				case 0x1: return Opcode::SET_I_MEGA;
+				case 0x2: return Opcode::LOAD_PALETTE;
+				case 0x3: return Opcode::SET_SPRITE_WIDTH;
+				case 0x4: return Opcode::SET_SPRITE_HEIGHT;
+				case 0x5: return Opcode::SET_SCREEN_ALPHA;
+				case 0x6: return n3 == 0 ? Opcode::PLAY_SAMPLE : Opcode::NOP;
+				case 0x7: return n34 == 0 ? Opcode::STOP_SAMPLE : Opcode::NOP;
+				case 0x8: return n3 == 0 ? Opcode::SET_BLEND_MODE : Opcode::NOP;
+				case 0x9: return Opcode::SET_COLLISION_COLOR;
+				default: return Opcode::NOP;
+				}
+				if (n3 == 0xB || n3 == 0xD) return Opcode::SCROLL_UP;
+				if (n3 == 0xC) return Opcode::SCROLL_DOWN;
+				switch (instruction.zeroType) {
+				case ZeroType::MEGA_OFF: return Opcode::MEGA_OFF;
+				case ZeroType::MEGA_ON: return Opcode::MEGA_ON;
+				case ZeroType::CLEAR: return Opcode::CLEAR;
+				case ZeroType::RET: return Opcode::RET;
+				case ZeroType::SCROLL_RIGHT: return Opcode::SCROLL_RIGHT;
+				case ZeroType::SCROLL_LEFT: return Opcode::SCROLL_LEFT;
+				case ZeroType::EXIT: return Opcode::EXIT;
+				case ZeroType::LOW_RES: return Opcode::LOW_RES;
+				case ZeroType::HIGH_RES: return Opcode::HIGH_RES;
+				default: return Opcode::NOP;
+				}
+			case JP: return Opcode::JP;
+			case CALL: return Opcode::CALL;
+			case SKIP_VX_EQ_NN: return Opcode::SKIP_VX_EQ_NN;
+			case SKIP_VX_NEQ_NN: return Opcode::SKIP_VX_NEQ_NN;
+			case SKIP_VX_NEQ_VY:
+				switch (instruction.rangeType) {
+				case RangeType::SAVE_VX_TO_VY: return Opcode::SAVE_VX_TO_VY;
+				case RangeType::LOAD_VX_TO_VY: return Opcode::LOAD_VX_TO_VY;
+				default: return Opcode::SKIP_VX_EQ_VY;
+				}
+			case VX_SET: return Opcode::VX_SET;
+			case VX_ADD: return Opcode::VX_ADD;
+			case ARITHMETIC:
+				switch (instruction.arithmeticType) {
+				case ArithmeticType::SET_VX_TO_VY: return Opcode::SET_VX_TO_VY;
+				case ArithmeticType::OR_VX_WITH_VY: return Opcode::OR_VX_WITH_VY;
+				case ArithmeticType::AND_VX_WITH_VY: return Opcode::AND_VX_WITH_VY;
+				case ArithmeticType::XOR_VX_WITH_VY: return Opcode::XOR_VX_WITH_VY;
+				case ArithmeticType::ADD_VY_TO_VX: return Opcode::ADD_VY_TO_VX;
+				case ArithmeticType::SUB_VY_FROM_VX: return Opcode::SUB_VY_FROM_VX;
+				case ArithmeticType::SR_VX_BY_VY: return Opcode::SR_VX_BY_VY;
+				case ArithmeticType::SUB_VX_FROM_VY: return Opcode::SUB_VX_FROM_VY;
+				case ArithmeticType::SL_VX_BY_VY: return Opcode::SL_VX_BY_VY;
+				default: return Opcode::UNKNOWN;
+				}
+			case SKIP_VX_EQ_VY: return Opcode::SKIP_VX_NEQ_VY;
+			case SET_I: return Opcode::SET_I;
+			case JR: return Opcode::JR;
+			case RANDOM: return Opcode::RANDOM;
+			case DRAW: return Opcode::DRAW;
+			case KEY:
+				switch (instruction.keyType) {
+				case KeyType::KEY_PRESSED: return Opcode::KEY_PRESSED;
+				case KeyType::KEY_NOT_PRESSED: return Opcode::KEY_NOT_PRESSED;
+				default: return Opcode::UNKNOWN;
+				}
+			case MISC:
+				switch (instruction.miscType) {
+				case MiscType::SET_VX_TO_DELAY: return Opcode::SET_VX_TO_DELAY;
+				case MiscType::WAIT_FOR_KEYPRESS: return Opcode::WAIT_FOR_KEYPRESS;
+				case MiscType::SET_DELAY_TO_VX: return Opcode::SET_DELAY_TO_VX;
+				case MiscType::SET_SOUND_TO_VX: return Opcode::SET_SOUND_TO_VX;
+				case MiscType::ADD_VX_TO_I: return Opcode::ADD_VX_TO_I;
+				case MiscType::SET_I_TO_HEX_CHARACTER: return Opcode::SET_I_TO_HEX_CHARACTER;
+				case MiscType::BCD_VX: return Opcode::BCD_VX;
+				case MiscType::SAVE_VX: return Opcode::SAVE_VX;
+				case MiscType::LOAD_VX: return Opcode::LOAD_VX;
+				case MiscType::SET_I_TO_BIG_CHARACTER: return Opcode::SET_I_TO_BIG_CHARACTER;
+				case MiscType::SAVE_FLAGS: return Opcode::SAVE_FLAGS;
+				case MiscType::LOAD_FLAGS: return Opcode::LOAD_FLAGS;
+				case MiscType::SET_I_LONG: return n2 == 0 ? Opcode::SET_I_LONG : Opcode::UNKNOWN;
+				case MiscType::SELECT_PLANES: return Opcode::SELECT_PLANES;
+				case MiscType::LOAD_AUDIO_PATTERN: return n2 == 0 ? Opcode::LOAD_AUDIO_PATTERN : Opcode::UNKNOWN;
+				case MiscType::SET_PITCH_TO_VX: return Opcode::SET_PITCH_TO_VX;
+				default: return Opcode::UNKNOWN;
+				}
+			default:
+				return Opcode::UNKNOWN;
+			}
+			}();
+
+		return instruction;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Chip8/Chip8.hpp"
+
+#include <cstdint>
+
+namespace ks {
+	// Adjusts a Chip8's rate to the ROM that runs on it, in whole instructions per frame. A ROM that
+	// spends much of its time waiting for the delay timer paces itself and is slowed down to save host
+	// time. One that never waits but keeps drawing is limited by the CPU, so it is sped up.
+	class Governor {
+	public:
+		// Instructions per 60 Hz frame.
+		struct Bounds {
+			int minimum{ 5 };
+			int maximum{ 1000 };
+		};
+
+		// The rate is reconsidered after this many frames of emulated time.
+		static constexpr int EVALUATION_FRAMES = 30;
+
+	public:
+		Governor() = default;
+		Governor(const Bounds bounds)
+			: m_bounds(bounds) {
+		}
+		~Governor() = default;
+
+		// Call after every batch of instructions. Does nothing until enough of them ran to judge.
+		auto update(Chip8& chip8) -> void;
+		// Forgets what was observed, for a new ROM.
+		auto reset() -> void;
+
+		auto get_bounds() const -> const Bounds& {
+			return m_bounds;
+		}
+		auto set_bounds(const Bounds bounds) -> void {
+			m_bounds = bounds;
+		}
+
+	private:
+		auto paid_off(const int perFrame, const double drawsPerInstruction) const -> bool;
+
+	private:
+		// What the ROM did before the last raise.
+		struct Sample {
+			int perFrame{};
+			double drawsPerInstruction{};
+		};
+
+		Bounds m_bounds;
+		bool m_started{};
+		uint64_t m_executed{};
+		uint64_t m_delayWait{};
+		uint64_t m_draws{};
+		Sample m_raisedFrom;
+	};
+}
@@ -24,8 +24,15 @@ namespace ks {
 
 	enum class ZeroType : uint8_t {
 		NOT_IMPORTANT = 0x00,
+		MEGA_OFF = 0x10,
+		MEGA_ON = 0x11,
 		CLEAR = 0xE0,
 		RET = 0xEE,
+		SCROLL_RIGHT = 0xFB,
+		SCROLL_LEFT = 0xFC,
+		EXIT = 0xFD,
+		LOW_RES = 0xFE,
+		HIGH_RES = 0xFF,
 	};
 
 	enum class ArithmeticType : uint8_t {
@@ -46,6 +53,9 @@ namespace ks {
 	};
 
 	enum class MiscType : uint8_t {
+		SET_I_LONG = 0x00,
+		SELECT_PLANES = 0x01,
+		LOAD_AUDIO_PATTERN = 0x02,
 		SET_VX_TO_DELAY = 0x07,
 		WAIT_FOR_KEYPRESS = 0x0A,
 		SET_DELAY_TO_VX = 0x15,
@@ -55,19 +65,111 @@ namespace ks {
 		BCD_VX = 0x33,
 		SAVE_VX = 0x55,
 		LOAD_VX = 0x65,
+		SET_I_TO_BIG_CHARACTER = 0x30,
+		SAVE_FLAGS = 0x75,
+		LOAD_FLAGS = 0x85,
+		SET_PITCH_TO_VX = 0x3A,
+	};
+
+	enum class RangeType : uint8_t {
+		SKIP_VX_EQ_VY = 0x0,
+		SAVE_VX_TO_VY = 0x2,
+		LOAD_VX_TO_VY = 0x3,
+	};
+
+	// Flat opcode index resolved once at decode time, used by the threaded dispatcher.
+	enum class Opcode : uint8_t {
+		UNKNOWN,
+		NOP,
+		CLEAR,
+		RET,
+		JP,
+		CALL,
+		SKIP_VX_EQ_NN,
+		SKIP_VX_NEQ_NN,
+		SKIP_VX_EQ_VY,
+		VX_SET,
+		VX_ADD,
+		SET_VX_TO_VY,
+		OR_VX_WITH_VY,
+		AND_VX_WITH_VY,
+		XOR_VX_WITH_VY,
+		ADD_VY_TO_VX,
+		SUB_VY_FROM_VX,
+		SR_VX_BY_VY,
+		SUB_VX_FROM_VY,
+		SL_VX_BY_VY,
+		SKIP_VX_NEQ_VY,
+		SET_I,
+		JR,
+		RANDOM,
+		DRAW,
+		KEY_PRESSED,
+		KEY_NOT_PRESSED,
+		SET_VX_TO_DELAY,
+		WAIT_FOR_KEYPRESS,
+		SET_DELAY_TO_VX,
+		SET_SOUND_TO_VX,
+		ADD_VX_TO_I,
+		SET_I_TO_HEX_CHARACTER,
+		BCD_VX,
+		SAVE_VX,
+		LOAD_VX,
+		SCROLL_DOWN,
+		SCROLL_RIGHT,
+		SCROLL_LEFT,
+		EXIT,
+		LOW_RES,
+		HIGH_RES,
+		SET_I_TO_BIG_CHARACTER,
+		SAVE_FLAGS,
+		LOAD_FLAGS,
+		SET_I_LONG,
+		SELECT_PLANES,
+		SAVE_VX_TO_VY,
+		LOAD_VX_TO_VY,
+		LOAD_AUDIO_PATTERN,
+		SET_PITCH_TO_VX,
+		MEGA_OFF,
+		MEGA_ON,
+		SCROLL_UP,
+		SET_I_MEGA,
+		LOAD_PALETTE,
+		SET_SPRITE_WIDTH,
+		SET_SPRITE_HEIGHT,
+		SET_SCREEN_ALPHA,
+		PLAY_SAMPLE,
+		STOP_SAMPLE,
+		SET_BLEND_MODE,
+		SET_COLLISION_COLOR,
+		COUNT,
+	};
+
+	// Hot instruction sequences executed by a single handler, found when the program is loaded.
+	enum class Fusion : uint8_t {
+		NONE,
+		DELAY_WAIT,		// FX07, 3X00, 1NNN back to FX07
+		LOAD_PAIR,		// 6XNN, 6YNN
+		SET_I_AND_DRAW,	// ANNN, DXYN
+		SKIP_JUMP,		// 3XNN/4XNN/5XY0/9XY0, 1NNN
+		COUNT,
 	};
 
 	struct Instruction {
 		InstructionType type{};
+		Opcode op{};
 		uint16_t address{};
 		uint8_t vx{};
 		uint8_t vy{};
+		// Fused sequence starting at this instruction, only valid in the predecoded cache.
+		Fusion fusion{};
 
 		union {
 			ZeroType zeroType;
 			ArithmeticType arithmeticType;
 			MiscType miscType;
 			KeyType keyType;
+			RangeType rangeType;
 			uint8_t literal{};
 		};
 	};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Chip8/Instruction.hpp"
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace ks {
+	// Translates runs of CHIP-8 instructions into x86-64 code. A block ends at the first control transfer
+	// or memory write; everything the emitter does not handle natively calls back into the interpreter
+	// through the fallback.
+	class Jit {
+	public:
+		static constexpr int ADDRESS_SPACE = 4096;
+		static constexpr int MAX_BLOCK_LENGTH = 32;
+
+		using Code = void (*)(void* context, uint8_t* registers);
+		using Fallback = void (*)(void* context, uint32_t opcode);
+
+		struct Block {
+			Code code{};
+			uint8_t length{};
+			// Index of the last instruction reading or writing a timer, -1 if there is none. Timers are
+			// advanced after the block, so it may only run if no tick is due before that instruction.
+			int8_t timerIndex{ -1 };
+			// Index of the first DXYN, -1 if there is none. The display wait quirk interprets such blocks.
+			int8_t drawIndex{ -1 };
+			bool translated{};
+		};
+
+		struct Layout {
+			uint8_t V{};
+			uint8_t PC{};
+			uint8_t I{};
+			uint8_t delay{};
+			uint8_t sound{};
+		};
+
+	public:
+		Jit(const Layout layout);
+		~Jit();
+
+		Jit(const Jit&) = delete;
+		auto operator =(const Jit&) -> Jit& = delete;
+
+		static auto is_supported() -> bool;
+
+		auto find(const uint16_t address) const -> const Block& {
+			return m_blocks[address];
+		}
+		auto translate(
+			const uint16_t address,
+			const std::span<const uint8_t, ADDRESS_SPACE> ram,
+			const std::span<const Instruction, ADDRESS_SPACE> decoded,
+			const Fallback fallback,
+			const bool shiftUsesVY
+		) -> const Block&;
+
+		auto invalidate(const uint16_t address) -> void;
+		auto flush() -> void;
+
+	private:
+		auto emit(const std::initializer_list<uint8_t> bytes) -> void;
+		auto emit16(const uint16_t value) -> void;
+		auto emit32(const uint32_t value) -> void;
+		auto emit64(const uint64_t value) -> void;
+
+		auto emit_prologue() -> void;
+		auto emit_epilogue() -> void;
+		auto emit_set_pc(const uint16_t value) -> void;
+		auto emit_fallback(const uint16_t opcode) -> void;
+
+	private:
+		uint8_t* m_code{};
+		size_t m_capacity{};
+		size_t m_used{};
+		std::vector<uint8_t> m_buffer;
+
+		std::array<Block, ADDRESS_SPACE> m_blocks{};
+		std::bitset<ADDRESS_SPACE> m_covered{};
+
+		Fallback m_fallback{};
+		Layout m_layout{};
+	};
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Chip8/Chip8.hpp"
+#include "Chip8/Instruction.hpp"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace ks {
+	// Runs LANES instances of one ROM side by side, each with its own keypad and random seed. State is
+	// kept as structure-of-arrays so an instruction executes for every lane sharing its PC at once;
+	// lanes that diverged wait until they are picked themselves. A lane runs plain low resolution
+	// CHIP-8 in CODE_SIZE bytes of memory exactly like a Chip8 with the same settings, seed and keypad.
+	class Lockstep {
+	public:
+		static constexpr int LANES = 32;
+		static constexpr int RAM_SIZE = Chip8::CODE_SIZE;
+
+		template<typename T>
+		using Lanes = std::array<T, LANES>;
+
+	public:
+		Lockstep();
+		~Lockstep() = default;
+
+		auto load_program(const fs::path& path) -> bool;
+		auto reset() -> void;
+		// Executes cycles instructions in every lane.
+		auto run(const int cycles) -> void;
+		// Every lane executed the same number of instructions, so their timers tick together.
+		auto get_cycles_to_tick() const -> int {
+			return static_cast<int>((Chip8::INSTRUCTIONS_PER_SECOND - m_tick[0] + Chip8::TIMER_FREQUENCY - 1) / Chip8::TIMER_FREQUENCY);
+		}
+
+		auto get_settings() const -> const Chip8::Settings& {
+			return m_settings;
+		}
+		auto set_settings(const Chip8::Settings& settings) -> void;
+		// The lane draws CXNN from the same sequence as a Chip8 given this seed, restarting on reset.
+		auto set_seed(const int lane, const uint64_t seed) -> void;
+		// Bit N is set while key N is held.
+		auto set_keys(const int lane, const uint16_t keys) -> void {
+			m_keys[lane] = keys;
+		}
+
+		auto get_display_memory(const int lane) const -> const Chip8::DisplayMemory& {
+			return m_displayMemory[lane];
+		}
+		auto get_registers(const int lane) const -> CPU::Registers;
+		auto should_play_sound(const int lane) const -> bool {
+			return m_playSound[lane];
+		}
+
+	private:
+		using Runner = void (Lockstep::*)(const int cycles);
+
+		template<Chip8::Quirks Q> auto run_lanes(const int cycles) -> void;
+		template<Chip8::Quirks Q> auto execute(const Instruction instruction, const Lanes<uint8_t>& group) -> void;
+		auto decode(const uint16_t address, const uint16_t opcode) -> Instruction;
+
+		// Lanes that need more than vector arithmetic go through the scalar semantics one at a time.
+		auto set_registers(const int lane, const CPU::Registers& registers) -> void;
+		template<Chip8::Quirks Q> auto draw(const Instruction instruction, const int lane) -> void;
+
+	private:
+		// Memory is interleaved, one row per address, so fetching an opcode for every lane is two loads.
+		std::vector<Lanes<uint8_t>> m_RAM;
+		std::array<Instruction, RAM_SIZE> m_decoded{};
+		std::array<uint16_t, RAM_SIZE> m_opcodes{};
+
+		alignas(32) std::array<Lanes<uint8_t>, 16> m_V{};
+		alignas(32) Lanes<uint16_t> m_PC{};
+		alignas(32) Lanes<uint16_t> m_I{};
+		alignas(32) Lanes<uint8_t> m_delay{};
+		alignas(32) Lanes<uint8_t> m_sound{};
+		alignas(32) Lanes<uint8_t> m_playSound{};
+		// Timer phase like Chip8's, at the default rate it stays below INSTRUCTIONS_PER_SECOND.
+		alignas(32) Lanes<uint16_t> m_tick{};
+		alignas(32) Lanes<uint16_t> m_remaining{};
+
+		std::array<Lanes<uint16_t>, 16> m_stack{};
+		Lanes<uint8_t> m_sp{};
+		Lanes<uint16_t> m_keys{};
+		Lanes<int8_t> m_heldKey{};
+		Lanes<uint64_t> m_seeds{};
+		Lanes<std::array<uint32_t, 4>> m_random{};
+
+		std::vector<Chip8::DisplayMemory> m_displayMemory;
+		Chip8::Settings m_settings;
+		Runner m_run{};
+		bool m_halted{ 1 };
+	};
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Chip8/Instruction.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace ks {
+	// Memory contents right after loading a ROM and the instructions decoded from them, shared by every
+	// instance that loaded the same one. Neither changes once the image exists.
+	class MemoryImage {
+	public:
+		~MemoryImage();
+
+		MemoryImage(const MemoryImage&) = delete;
+		auto operator =(const MemoryImage&) -> MemoryImage& = delete;
+
+		// Returns the live image of this ROM, nullptr if there is none. Images are looked up by a hash of
+		// the ROM and only compared byte for byte when it matches.
+		static auto find(const std::span<const uint8_t> rom) -> std::shared_ptr<const MemoryImage>;
+		// Makes the image of a ROM from the memory it starts out with, or returns the one another thread
+		// made in the meantime.
+		static auto share(const std::span<const uint8_t> rom, const std::span<const uint8_t> bytes, std::vector<Instruction> decoded) -> std::shared_ptr<const MemoryImage>;
+
+		auto get_bytes() const -> std::span<const uint8_t> {
+			return { m_bytes, m_size };
+		}
+		auto get_decoded() const -> std::span<const Instruction> {
+			return m_decoded;
+		}
+
+	private:
+		MemoryImage(const std::span<const uint8_t> rom, const std::span<const uint8_t> bytes, std::vector<Instruction> decoded);
+
+		static auto lookup(const uint64_t hash, const std::span<const uint8_t> rom) -> std::shared_ptr<const MemoryImage>;
+
+	private:
+		friend class Memory;
+
+		const uint8_t* m_bytes{};
+		size_t m_size{};
+		// The ROM the image was made from, which is what instances look it up by.
+		std::vector<uint8_t> m_rom;
+		std::vector<Instruction> m_decoded;
+		// Shared memory object the pages come from, a file mapping handle or a descriptor. Without one
+		// the bytes are kept in m_copy and every instance copies them.
+		intptr_t m_handle{ -1 };
+		std::vector<uint8_t> m_copy;
+	};
+
+	// Emulated memory. An image is mapped copy-on-write, so an instance only owns the pages it wrote to:
+	// the OS gives it a private copy of a page on the first write and shares the rest with every other
+	// instance of the ROM. Reads and writes are plain memory accesses either way.
+	class Memory {
+	public:
+		Memory(const size_t size);
+		~Memory();
+
+		Memory(const Memory&) = delete;
+		auto operator =(const Memory&) -> Memory& = delete;
+
+		// Private zeroed memory.
+		auto assign(const size_t size) -> void;
+		auto map(std::shared_ptr<const MemoryImage> image) -> void;
+		// Instances that could not map their image and hold a full copy of it instead, sharing nothing.
+		static auto get_copy_count() -> uint64_t;
+
+		auto data() -> uint8_t* {
+			return m_data;
+		}
+		auto data() const -> const uint8_t* {
+			return m_data;
+		}
+		auto size() const -> size_t {
+			return m_size;
+		}
+		auto operator [](const size_t index) -> uint8_t& {
+			return m_data[index];
+		}
+		auto operator [](const size_t index) const -> uint8_t {
+			return m_data[index];
+		}
+
+	private:
+		auto release() -> void;
+
+	private:
+		uint8_t* m_data{};
+		size_t m_size{};
+		// Set while m_data is a view of this image rather than memory of its own.
+		std::shared_ptr<const MemoryImage> m_image;
+	};
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Chip8/CPU.hpp"
+
+#include <cstdint>
+#include <span>
+
+namespace ks {
+	struct BootSnapshot;
+
+	// State handed to the functions emitted by chip8-recomp. Everything they do not translate is passed
+	// back to the interpreter as a raw opcode.
+	struct RecompiledContext {
+		CPU& cpu;
+		uint8_t* ram{};
+		void* chip8{};
+		void (*interpret)(void* chip8, uint32_t opcode){};
+		bool shiftUsesVY{};
+	};
+
+	struct RecompiledBlock {
+		uint16_t address{};
+		uint8_t length{};
+		int8_t timerIndex{ -1 };
+		int8_t drawIndex{ -1 };
+		void (*run)(RecompiledContext& context){};
+	};
+
+	struct RecompiledProgram {
+		std::span<const uint8_t> rom;
+		std::span<const RecompiledBlock> blocks;
+		// State after the boot sequence with default settings, if the ROM got that far at compile time.
+		const BootSnapshot* boot{};
+	};
+
+	// Called from the static initializers of generated translation units.
+	auto register_recompiled_program(const RecompiledProgram& program) -> bool;
+	auto find_recompiled_program(const std::span<const uint8_t> rom) -> const RecompiledProgram*;
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Chip8/Chip8.hpp"
+
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ks {
+	// Runs many Chip8 instances cooperatively on one thread. Every instance is a coroutine that yields
+	// after each 60 Hz timer tick. One that waits in FX0A stays suspended until its keypad changes
+	// instead of being polled, and one that halted is never resumed again.
+	class Scheduler {
+	public:
+		enum class State : uint8_t {
+			RUNNING,
+			WAITING_FOR_KEY,
+			HALTED,
+		};
+
+		class Task {
+		public:
+			struct promise_type {
+				State state{ State::RUNNING };
+
+				auto get_return_object() -> Task {
+					return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+				}
+				auto initial_suspend() -> std::suspend_always {
+					return {};
+				}
+				auto final_suspend() noexcept -> std::suspend_always {
+					return {};
+				}
+				auto yield_value(const State yielded) -> std::suspend_always {
+					state = yielded;
+					return {};
+				}
+				auto return_void() -> void {
+					state = State::HALTED;
+				}
+				auto unhandled_exception() -> void {
+					throw;
+				}
+			};
+
+		public:
+			Task() = default;
+			Task(std::coroutine_handle<promise_type> handle)
+				: m_handle(handle) {}
+			Task(Task&& other) noexcept
+				: m_handle(std::exchange(other.m_handle, {})) {}
+			auto operator=(Task&& other) noexcept -> Task& {
+				std::swap(m_handle, other.m_handle);
+				return *this;
+			}
+			~Task() {
+				if (m_handle) m_handle.destroy();
+			}
+
+			// Runs the instance up to its next yield and returns why it stopped.
+			auto resume() -> State {
+				m_handle.resume();
+				return m_handle.promise().state;
+			}
+
+		private:
+			std::coroutine_handle<promise_type> m_handle;
+		};
+
+	public:
+		// The instance has to outlive the scheduler. Returns its index for the other calls.
+		auto add(Chip8& chip8) -> int;
+		// Bit N is set while key N is held. A new keypad wakes an instance waiting in FX0A.
+		auto set_keys(const int instance, const uint16_t keys) -> void;
+		// Runs every instance that is not suspended for one timer tick.
+		auto run_tick() -> void;
+
+		auto get_state(const int instance) const -> State {
+			return m_instances[instance]->state;
+		}
+		auto get_running_count() const -> size_t {
+			return m_running.size();
+		}
+
+	private:
+		struct Instance {
+			Chip8* chip8{};
+			uint16_t keys{};
+			State state{ State::RUNNING };
+			// Tick the instance went to sleep in FX0A, its timers catch up when it wakes.
+			uint64_t suspendedAt{};
+			Task task;
+		};
+
+		static auto drive(Chip8& chip8, const uint16_t& keys) -> Task;
+
+	private:
+		// Instances are kept behind pointers, their coroutines hold on to the keypad.
+		std::vector<std::unique_ptr<Instance>> m_instances;
+		std::vector<int> m_running;
+		std::vector<int> m_next;
+		uint64_t m_tick{};
+	};
+}
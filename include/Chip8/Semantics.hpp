@@ -0,0 +1,194 @@
+#pragma once
+
+#include "Chip8/Chip8.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+namespace ks {
+	// What instructions do to the registers, memory and display, apart from how they are fetched and
+	// dispatched. Chip8 executes these, Lockstep runs them for every lane it does not vectorize and
+	// boot() evaluates them at compile time, so the three can not drift apart.
+	namespace semantics {
+		using Registers = CPU::Registers;
+
+		// 3XNN, 4XNN, 5XY0 and 9XY0.
+		template<Opcode OP>
+		constexpr auto skip_taken(const Registers& registers, const Instruction instruction) -> bool {
+			const auto& V = registers.V;
+			if constexpr (OP == Opcode::SKIP_VX_EQ_NN) return V[instruction.vx] == instruction.literal;
+			else if constexpr (OP == Opcode::SKIP_VX_NEQ_NN) return V[instruction.vx] != instruction.literal;
+			else if constexpr (OP == Opcode::SKIP_VX_EQ_VY) return V[instruction.vx] == V[instruction.vy];
+			else if constexpr (OP == Opcode::SKIP_VX_NEQ_VY) return V[instruction.vx] != V[instruction.vy];
+			else static_assert(OP == Opcode::SKIP_VX_EQ_NN, "not a skip");
+		}
+
+		// 8XY4, 8XY5, 8XY7, 8XY6 and 8XYE. VF is written last, so it holds the flag even when X is F.
+		constexpr auto add_vy_to_vx(Registers& registers, const int x, const int y) -> void {
+			const int sum = registers.V[x] + registers.V[y];
+			registers.V[x] = static_cast<uint8_t>(sum);
+			registers.V[0xF] = sum > 0xFF;
+		}
+		constexpr auto sub_vy_from_vx(Registers& registers, const int x, const int y) -> void {
+			const bool noBorrow = registers.V[x] >= registers.V[y];
+			registers.V[x] = static_cast<uint8_t>(registers.V[x] - registers.V[y]);
+			registers.V[0xF] = noBorrow;
+		}
+		constexpr auto sub_vx_from_vy(Registers& registers, const int x, const int y) -> void {
+			const bool noBorrow = registers.V[y] >= registers.V[x];
+			registers.V[x] = static_cast<uint8_t>(registers.V[y] - registers.V[x]);
+			registers.V[0xF] = noBorrow;
+		}
+		template<bool SHIFT_VY>
+		constexpr auto shift_right(Registers& registers, const int x, const int y) -> void {
+			const uint8_t value = registers.V[SHIFT_VY ? y : x];
+			registers.V[x] = value >> 1;
+			registers.V[0xF] = value & 0x1;
+		}
+		template<bool SHIFT_VY>
+		constexpr auto shift_left(Registers& registers, const int x, const int y) -> void {
+			const uint8_t value = registers.V[SHIFT_VY ? y : x];
+			registers.V[x] = static_cast<uint8_t>(value << 1);
+			registers.V[0xF] = value >> 7;
+		}
+
+		// FX1E. Spacefight 2091! relies on VF being set. XO-CHIP programs point I past 0xFFF on purpose,
+		// so only leaving the 12 bit range counts.
+		constexpr auto add_vx_to_i(Registers& registers, const int x) -> void {
+			const bool inRange = registers.I <= 0xFFF;
+			registers.I += registers.V[x];
+			if (inRange && registers.I > 0xFFF) {
+				registers.V[0xF] = 1;
+			}
+		}
+		// FX29.
+		constexpr auto set_i_to_hex_character(Registers& registers, const int x) -> void {
+			registers.I = Chip8::FONT_ADDRESS + (registers.V[x] & 0xF) * 5;
+			registers.bank = 0;
+		}
+		// FX33, the digits in the order they are stored.
+		constexpr auto bcd(const uint8_t value) -> std::array<uint8_t, 3> {
+			return { static_cast<uint8_t>(value / 100), static_cast<uint8_t>(value / 10 % 10), static_cast<uint8_t>(value % 10) };
+		}
+		// FX55 and FX65. write is called with the offset from I and the byte to store there, source
+		// holds at least x + 1 bytes from I on.
+		template<bool CHANGE_I, typename Write>
+		constexpr auto save_registers(Registers& registers, const int x, Write&& write) -> void {
+			for (int i = 0; i <= x; i++) {
+				write(i, registers.V[i]);
+			}
+			if constexpr (CHANGE_I) {
+				registers.I += x + 1;
+			}
+		}
+		template<bool CHANGE_I>
+		constexpr auto load_registers(Registers& registers, const int x, const uint8_t* source) -> void {
+			for (int i = 0; i <= x; i++) {
+				registers.V[i] = source[i];
+			}
+			if constexpr (CHANGE_I) {
+				registers.I += x + 1;
+			}
+		}
+
+		// Draws rows of sprite at x, y on one plane and returns the pixels that were already set. A large
+		// sprite is 16 pixels wide, two bytes per row. x and y are already inside the display.
+		template<bool CLIPPING>
+		constexpr auto draw_sprite(Chip8::DisplayMemory& display, const uint8_t* sprite, const int x, const int y, const int rows, const bool large, const bool highResolution) -> uint64_t {
+			const int height = highResolution ? Chip8::HIGH_RES_DISPLAY_Y : Chip8::DISPLAY_Y;
+
+			uint64_t collision = 0;
+			for (int i = 0; i < rows; i++) {
+				int row = y + i;
+				if constexpr (CLIPPING) {
+					if (row >= height) break;
+				}
+				else {
+					row &= (height - 1);
+				}
+
+				// Place the sprite row at the left edge, then move it to x. Clipped pixels fall off the
+				// right side, wrapped ones come back in on the left.
+				uint64_t bits = static_cast<uint64_t>(sprite[large ? i * 2 : i]) << 56;
+				if (large) {
+					bits |= static_cast<uint64_t>(sprite[i * 2 + 1]) << 48;
+				}
+
+				Chip8::DisplayRow& target = display[row];
+				if (!highResolution) {
+					const uint64_t shifted = CLIPPING ? bits >> x : std::rotr(bits, x);
+					collision |= target[0] & shifted;
+					target[0] ^= shifted;
+					continue;
+				}
+
+				// Both words form one 128 pixel row, bits leaving the second word wrap into the first.
+				const uint64_t left = x < 64 ? bits >> x : (CLIPPING || x == 64 ? 0 : bits << (128 - x));
+				const uint64_t right = x < 64 ? (x == 0 ? 0 : bits << (64 - x)) : bits >> (x - 64);
+				collision |= (target[0] & left) | (target[1] & right);
+				target[0] ^= left;
+				target[1] ^= right;
+			}
+			return collision;
+		}
+
+		// FX0A. The key is reported once it is released, until then the instruction repeats. held is the
+		// key seen pressed, -1 before that. Returns the released key, or -1 while the wait goes on.
+		constexpr auto wait_for_keypress(int8_t& held, const uint16_t keys) -> int {
+			if (held >= 0 && !(keys >> held & 1)) {
+				return std::exchange(held, static_cast<int8_t>(-1));
+			}
+			if (held < 0 && keys) {
+				held = static_cast<int8_t>(std::countr_zero(keys));
+			}
+			return -1;
+		}
+
+		// xoshiro128** state for CXNN.
+		using RandomState = std::array<uint32_t, 4>;
+
+		constexpr auto seed_random(RandomState& state, uint64_t seed) -> void {
+			// SplitMix64 spreads the seed over the whole state, which must not be all zero.
+			for (int i = 0; i < 4; i += 2) {
+				seed += 0x9E3779B97F4A7C15;
+				uint64_t z = seed;
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+				z ^= z >> 31;
+				state[i] = static_cast<uint32_t>(z);
+				state[i + 1] = static_cast<uint32_t>(z >> 32);
+			}
+		}
+		constexpr auto next_random(RandomState& state) -> uint8_t {
+			// The top byte is the best mixed one.
+			const uint32_t result = std::rotl(state[1] * 5, 7) * 9;
+			const uint32_t t = state[1] << 9;
+			state[2] ^= state[0];
+			state[3] ^= state[1];
+			state[1] ^= state[2];
+			state[0] ^= state[3];
+			state[2] ^= t;
+			state[3] = std::rotl(state[3], 11);
+			return static_cast<uint8_t>(result >> 24);
+		}
+
+		// FX07, 3XNN, 1NNN back to the FX07: a loop waiting for the delay timer. Every engine counts the
+		// instructions spent in it at the FX07, the whole round at once.
+		constexpr auto is_delay_wait(const uint16_t address, const Instruction first, const Instruction second, const Instruction third) -> bool {
+			return first.op == Opcode::SET_VX_TO_DELAY && second.op == Opcode::SKIP_VX_EQ_NN && second.vx == first.vx
+				&& third.op == Opcode::JP && third.address == address;
+		}
+		// Instructions in the round that just read value, the one that reads NN skips the jump and leaves.
+		constexpr auto delay_wait_round(const uint8_t value, const Instruction skip) -> int {
+			return value == skip.literal ? 2 : 3;
+		}
+
+		// Both timers count down by ticks, stopping at zero.
+		constexpr auto count_down(Registers& registers, const int ticks) -> void {
+			registers.delay = static_cast<uint8_t>(registers.delay > ticks ? registers.delay - ticks : 0);
+			registers.sound = static_cast<uint8_t>(registers.sound > ticks ? registers.sound - ticks : 0);
+		}
+	}
+}
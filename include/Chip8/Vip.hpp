@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace ks {
+	// Low level COSMAC VIP: an RCA CDP1802 with a CDP1861 video chip, running the original CHIP-8
+	// interpreter instead of emulating CHIP-8 instructions directly. Timing is counted in 1802 machine
+	// cycles, video DMA happens once per scanline at the cycle the 1861 would request it.
+	class Vip {
+	public:
+		static constexpr int RAM_SIZE = 0x1000;
+		static constexpr int INTERPRETER_SIZE = 0x200;
+		static constexpr int PROGRAM_START = 0x200;
+		// 1.76064 MHz clock, eight clocks per machine cycle.
+		static constexpr int CYCLES_PER_SECOND = 1'760'640 / 8;
+		static constexpr int CYCLES_PER_LINE = 14;
+		static constexpr int LINES = 262;
+		static constexpr int CYCLES_PER_FRAME = CYCLES_PER_LINE * LINES;
+
+		// The 1861 shows 128 lines of 64 pixels, CHIP-8 repeats every row four times.
+		static constexpr int DISPLAY_X = 64;
+		static constexpr int DISPLAY_Y = 128;
+		using DisplayMemory = std::array<uint64_t, DISPLAY_Y>;
+
+	public:
+		Vip();
+		~Vip() = default;
+
+		// The interpreter image is placed at 0000, the program after it at 0200.
+		auto load_program(const fs::path& interpreter, const fs::path& program) -> bool;
+		// Memory laid out like that by read_image, which can run on another thread than the instance.
+		auto load_image(const std::span<const uint8_t> image) -> bool;
+		static auto read_image(const fs::path& interpreter, const fs::path& program) -> std::optional<std::vector<uint8_t>>;
+		auto reset() -> void;
+		// Runs the machine for cycles machine cycles with the keypad latched, bit N is key N.
+		auto run_cycles(const int cycles, const uint16_t keypad) -> void;
+
+		auto get_display_memory() const -> const DisplayMemory& {
+			return m_displayMemory;
+		}
+		static auto is_pixel_set(const uint64_t row, const int x) -> bool {
+			return row >> (63 - x) & 1;
+		}
+		// Q drives the VIP's beeper.
+		auto should_play_sound() const -> bool {
+			return m_Q;
+		}
+		auto get_cycles() const -> uint64_t {
+			return m_cycles;
+		}
+		// Memory as the 1802 sees it.
+		auto get_memory() const -> const std::array<uint8_t, RAM_SIZE>& {
+			return m_RAM;
+		}
+
+	private:
+		using Handler = void (Vip::*)();
+
+		auto run_line() -> void;
+		auto execute_until(const uint64_t target) -> void;
+		auto interrupt() -> void;
+		auto dma(const int row) -> void;
+
+		template<uint8_t OPCODE>
+		auto execute() -> void;
+		template<int N>
+		auto flag() const -> bool;
+
+		auto read(const uint16_t address) const -> uint8_t {
+			return m_RAM[address & (RAM_SIZE - 1)];
+		}
+		auto write(const uint16_t address, const uint8_t value) -> void {
+			m_RAM[address & (RAM_SIZE - 1)] = value;
+		}
+		auto output(const int port, const uint8_t value) -> void;
+		auto input(const int port) -> uint8_t;
+
+	private:
+		std::array<uint8_t, RAM_SIZE> m_RAM{};
+		std::array<uint8_t, RAM_SIZE> m_image{};
+
+		// CDP1802 registers.
+		std::array<uint16_t, 16> m_R{};
+		uint8_t m_D{};
+		uint8_t m_P{};
+		uint8_t m_X{};
+		uint8_t m_T{};
+		bool m_DF{};
+		bool m_Q{};
+		bool m_IE{ 1 };
+		bool m_idle{};
+
+		// CDP1861 state, the line counter runs whether the display is on or not.
+		DisplayMemory m_displayMemory{};
+		int m_line{};
+		bool m_displayEnabled{};
+
+		uint64_t m_cycles{};
+		uint64_t m_lineStart{};
+		uint64_t m_targetCycles{};
+		uint16_t m_keys{};
+		uint8_t m_keyLatch{};
+		bool m_halted{ 1 };
+	};
+}
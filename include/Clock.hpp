@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ks {
+	// Turns host nanoseconds into machine cycles at an integer rate. Time that does not add up to a whole
+	// cycle is carried over exactly instead of being rounded away, so emulated time never drifts from
+	// the host clock however long a session runs.
+	class Clock {
+	public:
+		static constexpr int64_t NANOSECONDS_PER_SECOND = 1'000'000'000;
+
+	public:
+		Clock() = default;
+		Clock(const int64_t rate)
+			: m_rate(rate) {
+		}
+		~Clock() = default;
+
+		// Cycles that became due during nanoseconds of host time.
+		auto advance(const int64_t nanoseconds) -> int64_t {
+			m_remainder += nanoseconds * m_rate;
+			const int64_t cycles = m_remainder / NANOSECONDS_PER_SECOND;
+			m_remainder %= NANOSECONDS_PER_SECOND;
+			return cycles;
+		}
+		auto reset() -> void {
+			m_remainder = 0;
+		}
+
+		auto get_rate() const -> int64_t {
+			return m_rate;
+		}
+		// The started cycle keeps its progress.
+		auto set_rate(const int64_t rate) -> void {
+			m_rate = rate;
+		}
+
+	private:
+		int64_t m_rate{};
+		// Progress towards the next cycle, in cycles times nanoseconds.
+		int64_t m_remainder{};
+	};
+}
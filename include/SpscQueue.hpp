@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <utility>
+
+namespace ks {
+	// Fixed size queue between one producer thread and one consumer thread, without locks.
+	template<typename T, size_t CAPACITY>
+	class SpscQueue {
+		static_assert(std::has_single_bit(CAPACITY));
+
+	public:
+		SpscQueue() = default;
+		~SpscQueue() = default;
+
+		SpscQueue(const SpscQueue&) = delete;
+		auto operator =(const SpscQueue&) -> SpscQueue& = delete;
+
+		// Producer side. Returns 0 if the queue is full. Items are moved in and out, so one that owns
+		// memory leaves nothing behind in its slot.
+		auto push(T value) -> bool {
+			const size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_head.load(std::memory_order_acquire) == CAPACITY) return 0;
+
+			m_items[tail & (CAPACITY - 1)] = std::move(value);
+			m_tail.store(tail + 1, std::memory_order_release);
+			return 1;
+		}
+		// Consumer side. Returns 0 if the queue is empty.
+		auto pop(T& value) -> bool {
+			const size_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_tail.load(std::memory_order_acquire)) return 0;
+
+			value = std::move(m_items[head & (CAPACITY - 1)]);
+			m_head.store(head + 1, std::memory_order_release);
+			return 1;
+		}
+
+	private:
+		std::array<T, CAPACITY> m_items{};
+		alignas(64) std::atomic<size_t> m_head{};
+		alignas(64) std::atomic<size_t> m_tail{};
+	};
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace ks {
+	// Hands the newest of a stream of values from one thread to another, neither of them ever waits. The
+	// writer fills a buffer of its own and swaps it with the shared one, the reader swaps its buffer with
+	// the shared one when that holds something new. Values the reader did not get to are skipped.
+	template<typename T>
+	class TripleBuffer {
+	public:
+		TripleBuffer() = default;
+		~TripleBuffer() = default;
+
+		TripleBuffer(const TripleBuffer&) = delete;
+		auto operator =(const TripleBuffer&) -> TripleBuffer& = delete;
+
+		// Writer side. The buffer holds whatever was published in it before, not the last value.
+		auto back() -> T& {
+			return m_buffers[m_back];
+		}
+		auto publish() -> void {
+			m_back = m_shared.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+		}
+
+		// Reader side. Takes the newest published value if there is one, the value stays the same until
+		// the next call.
+		auto acquire() -> const T& {
+			if (m_shared.load(std::memory_order_relaxed) & FRESH) {
+				m_front = m_shared.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+			}
+			return m_buffers[m_front];
+		}
+		auto front() const -> const T& {
+			return m_buffers[m_front];
+		}
+
+	private:
+		static constexpr uint8_t INDEX = 0x3;
+		static constexpr uint8_t FRESH = 0x4;
+
+		std::array<T, 3> m_buffers{};
+		// Index of the buffer between the two threads, with FRESH set until the reader takes it.
+		alignas(64) std::atomic<uint8_t> m_shared{ 1 };
+		alignas(64) uint8_t m_back{ 0 };
+		alignas(64) uint8_t m_front{ 2 };
+	};
+}
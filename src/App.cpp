@@ -4,24 +4,62 @@
 #include <iostream>
 #include <cmath>
 #include <format>
+#include <limits>
 
 namespace ks {
 	constexpr static int AUDIO_STREAM_FREQUENCY = 8000;
 	constexpr static int PULSE_FREQUENCY = 1000;
+	// The original VIP CHIP-8 interpreter, which the user has to provide for the low level mode.
+	constexpr static const char* VIP_INTERPRETER = DATA_PATH "chip8-vip.bin";
+	constexpr static uint64_t DETERMINISTIC_SEED = 0xC8C8C8C8;
+	// Speeds fast-forward can be capped at, the first one leaves it to the host.
+	constexpr static std::array<float, 5> FAST_FORWARD_CAPS{ std::numeric_limits<float>::infinity(), 2.0f, 4.0f, 8.0f, 16.0f };
+	// The emulation thread steps the core and publishes a frame at the display rate, fast-forward
+	// included.
+	constexpr static int64_t FRAME_TIME = 1'000'000'000 / 60;
+
+	// Colors for the XO-CHIP plane combinations, 1 is the plain CHIP-8 pixel.
+	constexpr static std::array<uint8_t, 3> BACKGROUND{ 0, 10, 2 };
+	constexpr static std::array<std::array<uint8_t, 3>, 16> PALETTE{ {
+		{ 0, 10, 2 }, { 0, 255, 51 }, { 255, 170, 0 }, { 255, 255, 255 },
+		{ 0, 136, 255 }, { 170, 0, 255 }, { 255, 85, 85 }, { 85, 255, 255 },
+		{ 120, 120, 120 }, { 0, 130, 30 }, { 170, 100, 0 }, { 200, 200, 200 },
+		{ 0, 70, 150 }, { 100, 0, 150 }, { 150, 40, 40 }, { 40, 150, 150 },
+	} };
+
+	// Keyboard keys for CHIP-8 keys 0-F, laid out like the COSMAC VIP keypad or in order.
+	constexpr static std::array<SDL_Keycode, 16> KEYPAD{
+		SDLK_X, SDLK_1, SDLK_2, SDLK_3,
+		SDLK_Q, SDLK_W, SDLK_E, SDLK_A,
+		SDLK_S, SDLK_D, SDLK_Z, SDLK_C,
+		SDLK_4, SDLK_R, SDLK_F, SDLK_V,
+	};
+	constexpr static std::array<SDL_Keycode, 16> SEQUENTIAL_KEYPAD{
+		SDLK_1, SDLK_2, SDLK_3, SDLK_4,
+		SDLK_Q, SDLK_W, SDLK_E, SDLK_R,
+		SDLK_A, SDLK_S, SDLK_D, SDLK_F,
+		SDLK_Z, SDLK_X, SDLK_C, SDLK_V,
+	};
 
 	App::App(const std::string_view title, const int width, const int height)
 		:	m_window("Chip8Emulator", 640, 480, SDL_WINDOW_RESIZABLE) 
 	{
-		m_gameDisplay = SDL_CreateTexture(m_window, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, Chip8::DISPLAY_X, Chip8::DISPLAY_Y);
+		m_gameDisplay = SDL_CreateTexture(m_window, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, Chip8::HIGH_RES_DISPLAY_X, Vip::DISPLAY_Y);
 		SDL_SetTextureScaleMode(m_gameDisplay, SDL_SCALEMODE_NEAREST);
+		m_megaDisplay = SDL_CreateTexture(m_window, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, Chip8::MEGA_DISPLAY_X, Chip8::MEGA_DISPLAY_Y);
+		SDL_SetTextureScaleMode(m_megaDisplay, SDL_SCALEMODE_NEAREST);
+		SDL_SetTextureBlendMode(m_megaDisplay, SDL_BLENDMODE_BLEND);
 		SDL_SetRenderDrawBlendMode(m_window, SDL_BLENDMODE_BLEND);
 
 		SDL_SetEventEnabled(SDL_EVENT_DROP_FILE, 1);
 
-		m_display.resize(Chip8::DISPLAY_X);
-		for (int x = 0; x < Chip8::DISPLAY_X; x++) {
-			m_display[x].resize(Chip8::DISPLAY_Y);
-			for (int y = 0; y < Chip8::DISPLAY_Y; y++) {
+		m_speed.decay(4.0f);
+
+		m_display.resize(Chip8::HIGH_RES_DISPLAY_X);
+		m_colors.resize(Chip8::HIGH_RES_DISPLAY_X, std::vector<uint8_t>(Vip::DISPLAY_Y, 1));
+		for (int x = 0; x < Chip8::HIGH_RES_DISPLAY_X; x++) {
+			m_display[x].resize(Vip::DISPLAY_Y);
+			for (int y = 0; y < Vip::DISPLAY_Y; y++) {
 				m_display[x][y].decay(20.0f);
 			}
 		}
@@ -32,39 +70,51 @@ namespace ks {
 		spec.freq = AUDIO_STREAM_FREQUENCY;
 		m_audioStream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, nullptr, nullptr);
 		SDL_ResumeAudioStreamDevice(m_audioStream);
+
+		// MEGA-CHIP samples get their own stream on the same device, its format follows the sample.
+		m_sampleStream = SDL_CreateAudioStream(nullptr, nullptr);
+		SDL_BindAudioStream(SDL_GetAudioStreamDevice(m_audioStream), m_sampleStream);
 		
 		m_textEngine = TTF_CreateRendererTextEngine(m_window);
 		m_font = TTF_OpenFont(DATA_PATH "arial.ttf", 18);
 		m_text = TTF_CreateText(m_textEngine, m_font, "", 0);
+		m_speedText = TTF_CreateText(m_textEngine, m_font, "", 0);
 	}
 	App::~App() {
 		TTF_CloseFont(m_font);
 		TTF_DestroyRendererTextEngine(m_textEngine);
 		SDL_DestroyTexture(m_gameDisplay);
+		SDL_DestroyTexture(m_megaDisplay);
 		SDL_PauseAudioStreamDevice(m_audioStream);
+		SDL_DestroyAudioStream(m_sampleStream);
 		SDL_DestroyAudioStream(m_audioStream);
 	}
 
 	auto App::run() -> void {
+		m_emulation = std::jthread([this](const std::stop_token stop) { emulate(stop); });
 		int64_t last = SDL_GetTicksNS();
 
 		while (m_window.is_open()) {
 			const int64_t start = SDL_GetTicksNS();
 			handle_events();
 
-			const float deltaTime = [&]() -> float {
-				const float delta = (SDL_GetTicksNS() - last) / 1'000'000'000.0f;
-				return delta < 2.0f ? delta : 2.0f;
-			}();
+			// Whole nanoseconds, the emulated clocks count from this without rounding.
+			const int64_t elapsed = std::min<int64_t>(SDL_GetTicksNS() - last, 2 * Clock::NANOSECONDS_PER_SECOND);
 			last = SDL_GetTicksNS();
 
-			input(deltaTime);
-			update(deltaTime);
+			input(elapsed / 1'000'000'000.0f);
+			update(elapsed);
 			render();
 
-			const int64_t diff = start - SDL_GetTicksNS();
-			SDL_DelayPrecise(1'000'000'000 / 60 - diff);
+			const int64_t spent = SDL_GetTicksNS() - start;
+			if (spent < FRAME_TIME) {
+				SDL_DelayPrecise(FRAME_TIME - spent);
+			}
 		}
+
+		m_emulation.request_stop();
+		resume();
+		m_emulation.join();
 	}
 	auto App::handle_events() -> void {
 		m_keyboard.pre_event();
@@ -89,8 +139,10 @@ namespace ks {
 		if (m_keyboard.is_key_pressed_once(SDLK_ESCAPE)) {
 			m_paused = !m_paused;
 		}
+		m_simulationSpeed = m_keyboard.is_key_held(SDLK_TAB) ? FAST_FORWARD_CAPS[m_fastForwardCap] : 1.0f;
 
 		if (m_paused) {
+			park();
 			Chip8::Settings settings = m_chip8.get_settings();
 
 			if (m_keyboard.is_key_pressed_once(SDLK_F1)) {
@@ -105,37 +157,107 @@ namespace ks {
 			if (m_keyboard.is_key_pressed_once(SDLK_F4)) {
 				settings.clipping = !settings.clipping;
 			}
+			if (m_keyboard.is_key_pressed_once(SDLK_F12)) {
+				settings.displayWait = !settings.displayWait;
+			}
+			if (m_keyboard.is_key_pressed_once(SDLK_HOME)) {
+				settings.largeSprites = !settings.largeSprites;
+			}
 			if (m_keyboard.is_key_pressed_once(SDLK_F5)) {
-				settings.changeKeypad = !settings.changeKeypad;
+				m_changeKeypad = !m_changeKeypad;
+			}
+			if (m_keyboard.is_key_pressed_once(SDLK_F9)) {
+				m_deterministic = !m_deterministic;
+				m_chip8.set_seed(m_deterministic ? std::optional<uint64_t>(DETERMINISTIC_SEED) : std::nullopt);
+				m_clock.reset();
+				if (!m_romPath.empty()) {
+					reload();
+				}
+			}
+			if (m_keyboard.is_key_pressed_once(SDLK_F8)) {
+				m_lowLevel = !m_lowLevel;
+				if (!m_romPath.empty()) {
+					reload();
+				}
+			}
+			// In steps of whole instructions per timer tick.
+			if (m_keyboard.is_key_pressed_once(SDLK_PAGEUP)) {
+				m_chip8.set_instructions_per_second(m_chip8.get_instructions_per_second() + Chip8::TIMER_FREQUENCY);
+			}
+			if (m_keyboard.is_key_pressed_once(SDLK_PAGEDOWN)) {
+				m_chip8.set_instructions_per_second(std::max(m_chip8.get_instructions_per_second() - Chip8::TIMER_FREQUENCY, Chip8::TIMER_FREQUENCY));
+			}
+			if (m_keyboard.is_key_pressed_once(SDLK_F10)) {
+				m_adaptive = !m_adaptive;
+				m_governor.reset();
+			}
+			if (m_keyboard.is_key_pressed_once(SDLK_F11)) {
+				m_fastForwardCap = (m_fastForwardCap + 1) % FAST_FORWARD_CAPS.size();
+			}
+			if (m_keyboard.is_key_pressed_once(SDLK_F7)) {
+				switch (m_chip8.get_engine()) {
+				case Chip8::Engine::SWITCH: m_chip8.set_engine(Chip8::Engine::THREADED); break;
+				case Chip8::Engine::THREADED: m_chip8.set_engine(Jit::is_supported() ? Chip8::Engine::JIT : Chip8::Engine::RECOMPILED); break;
+				case Chip8::Engine::JIT: m_chip8.set_engine(Chip8::Engine::RECOMPILED); break;
+				case Chip8::Engine::RECOMPILED: m_chip8.set_engine(Chip8::Engine::SWITCH); break;
+				}
 			}
 
 			m_chip8.set_settings(settings);
 		}
+		if (!m_paused) {
+			resume();
+			// A ROM waiting to be loaded goes with the first input that fits into the queue.
+			if (m_inputs.push({ read_keypad(), m_simulationSpeed, m_program })) {
+				m_program.reset();
+			}
+		}
 	}
-	auto App::update(const float deltaTime) -> void {
-		static constexpr float tick = 1.0f / 531.0f;
+	auto App::update(const int64_t elapsed) -> void {
+		const float deltaTime = elapsed / 1'000'000'000.0f;
+		const Frame& frame = m_frames.acquire();
 
 		if (!m_paused) {
-			m_accumulator += deltaTime;
-			while (m_accumulator >= tick / m_simulationSpeed) {
-				m_chip8.update(m_keyboard);
-				m_accumulator -= tick / m_simulationSpeed;
+			m_speed = frame.speed;
+			m_speed.update(deltaTime);
+			if (m_simulationSpeed > 1.0f) {
+				TTF_SetTextString(m_speedText, std::format("Fast-forward {:.1f}x", m_speed.value()).c_str(), 0);
 			}
 
-			const auto& displayMemory = m_chip8.get_display_memory();
-			for (int x = 0; x < Chip8::DISPLAY_X; x++) {
-				for (int y = 0; y < Chip8::DISPLAY_Y; y++) {
-					m_display[x][y] = displayMemory[x][y];
+			for (int y = 0; y < frame.height && !frame.mega; y++) {
+				for (int x = 0; x < frame.width; x++) {
+					const uint8_t color = frame.pixels[x][y];
+					// A pixel that turns off fades out in the color it had.
+					if (color) {
+						m_colors[x][y] = color;
+					}
+					m_display[x][y] = color != 0;
 					m_display[x][y].update(deltaTime);
 				}
 			}
 
-			if (m_chip8.should_play_sound()) {
-				play_sine_wave();
+			if (frame.playSound) {
+				if (frame.hasAudioPattern) {
+					play_pattern(frame);
+				}
+				else {
+					play_sine_wave();
+				}
 			} 
 			else {
 				SDL_ClearAudioStream(m_audioStream);
 			}
+			play_sample(frame);
+		}
+
+		if (frame.mega) {
+			// MEGA-CHIP frames are finished by the ROM itself, so there is nothing to fade and
+			// the texture only needs an upload when 00E0 produced a new one.
+			if (m_uploadedFrame != frame.megaFrameCount) {
+				m_uploadedFrame = frame.megaFrameCount;
+				SDL_UpdateTexture(m_megaDisplay, nullptr, frame.megaFrame.data(), Chip8::MEGA_DISPLAY_X * sizeof(uint32_t));
+			}
+			SDL_SetTextureAlphaMod(m_megaDisplay, frame.screenAlpha);
 		}
 
 		Uint32* pixels{};
@@ -143,12 +265,13 @@ namespace ks {
 		int format{};
 		SDL_LockTexture(m_gameDisplay, nullptr, reinterpret_cast<void**>(&pixels), &pitch);
 
-		for (int x = 0; x < Chip8::DISPLAY_X; x++) {
-			for (int y = 0; y < Chip8::DISPLAY_Y; y++) {
+		for (int x = 0; x < frame.width && !frame.mega; x++) {
+			for (int y = 0; y < frame.height; y++) {
 				const Uint32 pixelPosition = y * (pitch / sizeof(unsigned int)) + x;
-				const uint8_t r = 0;
-				const uint8_t g = static_cast<uint8_t>(255.0f * m_display[x][y] + 10.0f * (1.0f - m_display[x][y]));
-				const uint8_t b = static_cast<uint8_t>(51.0f * m_display[x][y] + 2.0f * (1.0f - m_display[x][y]));
+				const std::array<uint8_t, 3>& color = PALETTE[m_colors[x][y]];
+				const uint8_t r = static_cast<uint8_t>(color[0] * m_display[x][y] + BACKGROUND[0] * (1.0f - m_display[x][y]));
+				const uint8_t g = static_cast<uint8_t>(color[1] * m_display[x][y] + BACKGROUND[1] * (1.0f - m_display[x][y]));
+				const uint8_t b = static_cast<uint8_t>(color[2] * m_display[x][y] + BACKGROUND[2] * (1.0f - m_display[x][y]));
 
 				pixels[pixelPosition] = 0xFF << 24 | b << 16 | g << 8 | r;
 			}
@@ -163,8 +286,24 @@ namespace ks {
 				<< "\n[F2] Use VX instead of V0: " << (settings.useVXinsteadOfV0 ? "ON" : "OFF")
 				<< "\n[F3] Change value of I: " << (settings.changeValueOfI ? "ON" : "OFF")
 				<< "\n[F4] Clipping: " << (settings.clipping ? "ON" : "OFF")
-				<< "\n[F5] Change keypad: " << (settings.changeKeypad ? "ON" : "OFF")
-				<< "\n\n[F6] Reload ROM";
+				<< "\n[F12] Display wait: " << (settings.displayWait ? "ON" : "OFF")
+				<< "\n[Home] 16x16 sprites in low resolution: " << (settings.largeSprites ? "ON" : "OFF")
+				<< "\n[F5] Change keypad: " << (m_changeKeypad ? "ON" : "OFF")
+				<< "\n[F8] COSMAC VIP low level mode: " << (m_lowLevel ? "ON" : "OFF")
+				<< "\n[F9] Deterministic: " << (m_deterministic ? "ON" : "OFF")
+				<< "\n[PgUp/PgDn] CPU rate: " << m_chip8.get_instructions_per_second() << " instructions/s"
+				<< "\n[F10] Adaptive CPU rate: " << (m_adaptive ? "ON" : "OFF")
+				<< "\n[F11] Fast-forward (hold Tab) cap: " << (std::isinf(FAST_FORWARD_CAPS[m_fastForwardCap]) ? std::string("none") : std::format("{}x", FAST_FORWARD_CAPS[m_fastForwardCap]))
+				<< "\n\n[F6] Reload ROM"
+				<< "\n[F7] Engine: " << [&]() {
+					switch (m_chip8.get_engine()) {
+					case Chip8::Engine::THREADED: return "Threaded";
+					case Chip8::Engine::JIT: return "JIT";
+					case Chip8::Engine::RECOMPILED: return m_chip8.has_recompiled_program() ? "Recompiled" : "Recompiled (not available for this ROM)";
+					default: return "Switch";
+					}
+					}()
+				<< "\n\nCore speed: " << static_cast<int64_t>(frame.instructionsPerSecond) << (m_lowLevel ? " machine cycles/s" : " instructions/s");
 
 			TTF_SetTextString(m_text, ss.str().c_str(), 0);
 		}
@@ -172,24 +311,33 @@ namespace ks {
 	auto App::render() -> void {
 		SDL_RenderClear(m_window);
 		
-		const float scaleX = std::floor(m_window.get_width() / Chip8::DISPLAY_X);
-		const float scaleY = std::floor(m_window.get_height() / Chip8::DISPLAY_Y);
+		const Frame& frame = m_frames.front();
+		const bool mega = frame.mega;
+		const int width = mega ? Chip8::MEGA_DISPLAY_X : frame.width;
+		const int height = mega ? Chip8::MEGA_DISPLAY_Y : frame.height;
+		// The 1861's 128 lines fill the same screen area as 32 CHIP-8 rows.
+		const int screenHeight = frame.lowLevel ? Chip8::DISPLAY_Y : height;
+		const float scaleX = std::floor(m_window.get_width() / width);
+		const float scaleY = std::floor(m_window.get_height() / screenHeight);
 		const float scale = std::min(scaleX, scaleY);
 
-		const float sizeX = Chip8::DISPLAY_X * scale;
-		const float sizeY = Chip8::DISPLAY_Y * scale;
+		const float sizeX = width * scale;
+		const float sizeY = screenHeight * scale;
 		const float offsetX = (m_window.get_width() - sizeX) / 2;
 		const float offsetY = (m_window.get_height() - sizeY) / 2;
 
-		const SDL_FRect srcRect{ 0.0f, 0.0f, static_cast<float>(Chip8::DISPLAY_X), static_cast<float>(Chip8::DISPLAY_Y) };
+		const SDL_FRect srcRect{ 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height) };
 		const SDL_FRect dstRect{ offsetX, offsetY, sizeX, sizeY };
-		SDL_RenderTexture(m_window, m_gameDisplay, &srcRect, &dstRect);
+		SDL_RenderTexture(m_window, mega ? m_megaDisplay : m_gameDisplay, &srcRect, &dstRect);
 
 		if (m_paused) {
 			SDL_SetRenderDrawColor(m_window, 0, 0, 0, 150);
 			SDL_RenderFillRect(m_window, nullptr);
 			TTF_DrawRendererText(m_text, 10, 10);
 		}
+		else if (m_simulationSpeed > 1.0f) {
+			TTF_DrawRendererText(m_speedText, 10, 10);
+		}
 
 		SDL_SetRenderDrawColor(m_window, 0, 0, 0, 255);
 		SDL_RenderPresent(m_window);
@@ -212,12 +360,221 @@ namespace ks {
 		}
 	}
 
+	auto App::play_pattern(const Frame& frame) -> void {
+		const int minimumSize = AUDIO_STREAM_FREQUENCY * sizeof(float) / 2.0f;
+		if (SDL_GetAudioStreamQueued(m_audioStream) < minimumSize) {
+			const std::array<uint8_t, 16>& pattern = frame.audioPattern;
+			const float step = frame.audioPatternRate / AUDIO_STREAM_FREQUENCY;
+			std::array<float, 1024> samples;
+
+			for (size_t i = 0; i < samples.size(); i++) {
+				const int bit = static_cast<int>(m_patternPosition) & 127;
+				samples[i] = (pattern[bit >> 3] >> (7 - (bit & 7)) & 1) ? 0.5f : -0.5f;
+				m_patternPosition += step;
+			}
+
+			m_patternPosition = std::fmod(m_patternPosition, 128.0f);
+
+			SDL_PutAudioStreamData(m_audioStream, samples.data(), samples.size() * sizeof(float));
+		}
+	}
+
+	auto App::play_sample(const Frame& frame) -> void {
+		if (frame.sample.empty()) {
+			SDL_ClearAudioStream(m_sampleStream);
+			return;
+		}
+
+		if (m_playedSample != frame.sampleSerial) {
+			m_playedSample = frame.sampleSerial;
+			SDL_ClearAudioStream(m_sampleStream);
+
+			SDL_AudioSpec spec;
+			spec.format = SDL_AUDIO_U8;
+			spec.channels = 1;
+			spec.freq = frame.sampleRate > 0 ? frame.sampleRate : AUDIO_STREAM_FREQUENCY;
+			SDL_SetAudioStreamFormat(m_sampleStream, &spec, nullptr);
+			SDL_PutAudioStreamData(m_sampleStream, frame.sample.data(), static_cast<int>(frame.sample.size()));
+		}
+		else if (frame.sampleLoop && SDL_GetAudioStreamQueued(m_sampleStream) < static_cast<int>(frame.sample.size()) / 2) {
+			SDL_PutAudioStreamData(m_sampleStream, frame.sample.data(), static_cast<int>(frame.sample.size()));
+		}
+	}
+
+	auto App::read_keypad() const -> uint16_t {
+		const std::array<SDL_Keycode, 16>& keypad = m_changeKeypad ? SEQUENTIAL_KEYPAD : KEYPAD;
+
+		uint16_t keys = 0;
+		for (int i = 0; i < 16; i++) {
+			if (m_keyboard.is_key_held(keypad[i])) {
+				keys |= 1 << i;
+			}
+		}
+		return keys;
+	}
+	auto App::emulate(const std::stop_token stop) -> void {
+		int64_t last = SDL_GetTicksNS();
+		while (!stop.stop_requested()) {
+			if (m_parkRequested.load(std::memory_order_acquire)) {
+				m_parked.store(1, std::memory_order_release);
+				m_parked.notify_one();
+				m_parkRequested.wait(1, std::memory_order_acquire);
+				m_parked.store(0, std::memory_order_release);
+				m_parked.notify_one();
+				// Time spent parked is not emulated.
+				last = SDL_GetTicksNS();
+				continue;
+			}
+
+			const int64_t start = SDL_GetTicksNS();
+			for (Input input; m_inputs.pop(input);) {
+				if (input.program) {
+					load(*input.program);
+					input.program.reset();
+				}
+				m_input = std::move(input);
+			}
+
+			// Whole nanoseconds, the emulated clocks count from this without rounding.
+			const int64_t elapsed = std::min<int64_t>(start - last, 2 * Clock::NANOSECONDS_PER_SECOND);
+			last = start;
+			step(elapsed);
+			publish();
+
+			const int64_t spent = SDL_GetTicksNS() - start;
+			if (spent < FRAME_TIME) {
+				SDL_DelayPrecise(FRAME_TIME - spent);
+			}
+		}
+	}
+	auto App::load(const std::vector<uint8_t>& program) -> void {
+		// The main thread read and checked it, this only fails if the size does not fit the mode.
+		if (m_lowLevel) {
+			m_vip.load_image(program);
+		}
+		else {
+			m_chip8.load_program(program);
+		}
+		m_governor.reset();
+	}
+	auto App::step(const int64_t elapsed) -> void {
+		const float deltaTime = elapsed / 1'000'000'000.0f;
+		const uint64_t start = SDL_GetTicksNS();
+		const uint64_t executedBefore = get_executed();
+		// The core runs whole frames, so every published one is the display at a vertical blank. Past
+		// the normal speed it runs them until the cap or the frame's time is used up.
+		const bool fastForward = m_input.speed > 1.0f;
+		const uint64_t deadline = start + FRAME_TIME;
+		// Without a cap the deadline is the only limit.
+		int64_t frames = std::numeric_limits<int64_t>::max();
+		if (!std::isinf(m_input.speed) && m_deterministic) {
+			// A fixed amount of work per step instead of wall clock time.
+			frames = static_cast<int64_t>(m_input.speed);
+		}
+		else if (!std::isinf(m_input.speed)) {
+			m_clock.set_rate(static_cast<int64_t>(Chip8::TIMER_FREQUENCY * m_input.speed));
+			frames = m_clock.advance(elapsed);
+		}
+
+		for (int64_t frame = 0; frame < frames; frame++) {
+			run_frame();
+			if (fastForward && SDL_GetTicksNS() >= deadline) break;
+		}
+		m_coreTime += SDL_GetTicksNS() - start;
+
+		// Emulated time over host time.
+		const double normal = static_cast<double>(m_lowLevel ? Vip::CYCLES_PER_SECOND : m_chip8.get_instructions_per_second()) * elapsed / Clock::NANOSECONDS_PER_SECOND;
+		if (normal > 0.0) {
+			m_measuredSpeed = static_cast<float>((get_executed() - executedBefore) / normal);
+		}
+
+		// Host throughput of the core, so the dispatch engines can be compared on the same ROM.
+		m_measureTime += deltaTime;
+		if (m_measureTime >= 1.0f) {
+			const uint64_t executed = get_executed();
+			if (m_coreTime > 0) {
+				m_instructionsPerSecond = (executed - m_measuredInstructions) * 1'000'000'000.0 / m_coreTime;
+			}
+			m_measuredInstructions = executed;
+			m_measureTime = 0.0f;
+			m_coreTime = 0;
+		}
+	}
+	auto App::run_frame() -> void {
+		if (m_lowLevel) {
+			m_vip.run_cycles(Vip::CYCLES_PER_FRAME, m_input.keys);
+			return;
+		}
+
+		m_chip8.run_frame(m_input.keys);
+		if (m_adaptive) {
+			m_governor.update(m_chip8);
+		}
+	}
+	auto App::publish() -> void {
+		Frame& frame = m_frames.back();
+		frame.lowLevel = m_lowLevel;
+		frame.mega = is_mega_chip();
+		frame.width = get_display_width();
+		frame.height = get_display_height();
+		for (int y = 0; y < frame.height && !frame.mega; y++) {
+			for (int x = 0; x < frame.width; x++) {
+				uint8_t color = 0;
+				if (m_lowLevel) {
+					color = Vip::is_pixel_set(m_vip.get_display_memory()[y], x);
+				}
+				for (int plane = 0; plane < Chip8::PLANES && !m_lowLevel; plane++) {
+					color |= Chip8::is_pixel_set(m_chip8.get_display_row(plane, y), x) << plane;
+				}
+				frame.pixels[x][y] = color;
+			}
+		}
+
+		// The buffer may still hold the MEGA-CHIP frame or the sample, they are only copied when they change.
+		if (frame.mega) {
+			if (frame.megaFrameCount != m_chip8.get_mega_frame_count() || frame.megaFrame.empty()) {
+				const std::span<const uint32_t> pixels = m_chip8.get_mega_frame();
+				frame.megaFrame.assign(pixels.begin(), pixels.end());
+				frame.megaFrameCount = m_chip8.get_mega_frame_count();
+			}
+			frame.screenAlpha = m_chip8.get_screen_alpha();
+		}
+		const Chip8::Sample& sample = m_chip8.get_sample();
+		if (frame.sampleSerial != sample.serial || frame.sample.size() != sample.data.size()) {
+			frame.sample.assign(sample.data.begin(), sample.data.end());
+			frame.sampleSerial = sample.serial;
+		}
+		frame.sampleRate = sample.rate;
+		frame.sampleLoop = sample.loop;
+
+		frame.playSound = m_lowLevel ? m_vip.should_play_sound() : m_chip8.should_play_sound();
+		frame.hasAudioPattern = !m_lowLevel && m_chip8.has_audio_pattern();
+		frame.audioPattern = m_chip8.get_audio_pattern();
+		frame.audioPatternRate = m_chip8.get_audio_pattern_rate();
+		frame.speed = m_measuredSpeed;
+		frame.instructionsPerSecond = m_instructionsPerSecond;
+		m_frames.publish();
+	}
+	auto App::park() -> void {
+		m_parkRequested.store(1, std::memory_order_release);
+		m_parked.wait(0, std::memory_order_acquire);
+	}
+	auto App::resume() -> void {
+		if (!m_parkRequested.exchange(0, std::memory_order_acq_rel)) return;
+		m_parkRequested.notify_one();
+		m_parked.wait(1, std::memory_order_acquire);
+	}
 	auto App::reload() -> void {
 		const std::string filename = m_romPath.filename().string();
-		if (!m_chip8.load_program(m_romPath)) {
+		std::optional<std::vector<uint8_t>> program = m_lowLevel ? Vip::read_image(VIP_INTERPRETER, m_romPath) : Chip8::read_program(m_romPath);
+		if (m_lowLevel && !program) {
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", std::format("Could not load {} with the interpreter from {}", filename, VIP_INTERPRETER).c_str(), m_window);
+		}
+		else if (!program) {
 			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", std::format("Could not load {}", filename).c_str(), m_window);
 		}
 		else {
+			m_program = std::move(program);
 			m_paused = 0;
 		}
 	}
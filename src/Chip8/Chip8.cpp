@@ -1,4 +1,6 @@
 #include "Chip8/Chip8.hpp"
+#include "Chip8/Boot.hpp"
+#include "Chip8/Semantics.hpp"
 
 #include <iostream>
 #include <format>
@@ -6,298 +8,568 @@
 #include <string_view>
 #include <random>
 #include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <span>
+#include <bit>
+#include <utility>
 
 namespace ks {
-	static auto random(int minValue, int maxValue) -> int {
-		static std::random_device rd;
-		static std::mt19937_64 mt(rd());
-
-		std::uniform_int_distribution<int> dist(minValue, maxValue);
-		return dist(mt);
-	}
+	// What an instance decodes before it loads a ROM.
+	static const std::array<Instruction, Chip8::CODE_SIZE> NOTHING_DECODED{};
 
 	Chip8::Chip8() {
+		m_decoded = NOTHING_DECODED.data();
 		m_cpu.halted = 1;
+		set_settings(m_settings);
 	}
 
+	// A ROM that cannot be loaded leaves the previous one untouched. Everything that describes memory
+	// is only replaced once the new contents are read.
 	auto Chip8::load_program(const fs::path& path) -> bool {
-		std::memset(m_RAM.data(), 0, m_RAM.size());
-		m_displayMemory = {};
-
+		const std::optional<std::vector<uint8_t>> rom = read_program(path);
+		return rom && load_program(*rom);
+	}
+	auto Chip8::read_program(const fs::path& path) -> std::optional<std::vector<uint8_t>> {
 		if (!fs::exists(path)) {
-			return 0;
+			return std::nullopt;
 		}
 
-		if (fs::file_size(path) > m_RAM.size()) {
-			return 0;
+		const size_t size = fs::file_size(path);
+		if (size > MAX_RAM_SIZE - 0x200) {
+			return std::nullopt;
 		}
 
 		std::ifstream file(path, std::ios::binary);
 		if (!file) {
+			return std::nullopt;
+		}
+
+		std::vector<uint8_t> rom(size);
+		file.read(reinterpret_cast<char*>(rom.data()), static_cast<std::streamsize>(size));
+		if (file.bad()) {
+			return std::nullopt;
+		}
+		rom.resize(static_cast<size_t>(file.gcount()));
+		return rom;
+	}
+	auto Chip8::load_program(const std::span<const uint8_t> rom) -> bool {
+		if (rom.size() > MAX_RAM_SIZE - 0x200) {
 			return 0;
 		}
+		const size_t ramSize = std::max<size_t>(RAM_SIZE, std::bit_ceil(rom.size() + 0x200));
 
-		file.read(reinterpret_cast<char*>(m_RAM.data() + 0x200), 3584);
-		file.close();
-
-		static constexpr std::array<uint8_t, 80> font{
-			0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
-			0x20, 0x60, 0x20, 0x20, 0x70, // 1
-			0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
-			0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
-			0x90, 0x90, 0xF0, 0x10, 0x10, // 4
-			0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
-			0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
-			0xF0, 0x10, 0x20, 0x40, 0x40, // 7
-			0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
-			0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
-			0xF0, 0x90, 0xF0, 0x90, 0x90, // A
-			0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
-			0xF0, 0x80, 0x80, 0x80, 0xF0, // C
-			0xE0, 0x90, 0x90, 0x90, 0xE0, // D
-			0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
-			0xF0, 0x80, 0xF0, 0x80, 0x80  // F
-		};
-		std::memcpy(m_RAM.data() + 0x50, font.data(), font.size());
+		// Memory as every instance of this ROM starts out and its decoded instructions, built once and
+		// shared by all of them.
+		std::shared_ptr<const MemoryImage> image = MemoryImage::find(rom);
+		if (!image) {
+			std::vector<uint8_t> bytes(ramSize + RAM_GUARD);
+			std::ranges::copy(rom, bytes.begin() + 0x200);
+			std::memcpy(bytes.data() + FONT_ADDRESS, FONT.data(), FONT.size());
+			std::memcpy(bytes.data() + BIG_FONT_ADDRESS, BIG_FONT.data(), BIG_FONT.size());
+			std::memcpy(bytes.data() + ramSize, bytes.data(), RAM_GUARD);
+
+			std::vector<Instruction> decoded(CODE_SIZE);
+			const std::span<Instruction, CODE_SIZE> table(decoded.data(), CODE_SIZE);
+			for (int address = 0; address < CODE_SIZE; address++) {
+				predecode(table, bytes.data(), address);
+			}
+			for (int address = 0; address < CODE_SIZE; address++) {
+				fuse(table, address);
+			}
+			image = MemoryImage::share(rom, bytes, std::move(decoded));
+		}
+
+		m_recompiledBlocks.clear();
+		const RecompiledProgram* program = find_recompiled_program(rom);
+		if (program) {
+			m_recompiledBlocks.resize(CODE_SIZE);
+			for (const RecompiledBlock& block : program->blocks) {
+				m_recompiledBlocks[block.address] = &block;
+			}
+		}
+
+		m_RAM.map(image);
+		m_ramMask = static_cast<uint32_t>(ramSize - 1);
+		m_displayMemory = {};
+
+		m_image = std::move(image);
+		m_ownDecoded.reset();
+		m_decoded = m_image->get_decoded().data();
+		if (m_jit) {
+			m_jit->flush();
+		}
 
 		reset();
+		// Snapshots are taken at the default rate, the timers would be out of phase at any other.
+		const bool bootable = program && program->boot && program->boot->executed > 0;
+		if (bootable && program->boot->settings == m_settings && m_instructionsPerSecond == INSTRUCTIONS_PER_SECOND) {
+			restore(*program->boot);
+		}
 		return 1;
 	}
 	auto Chip8::reset() -> void {
 		m_cpu = {};
 		m_cpu.registers.PC = 0x200;
+		m_highResolution = 0;
+		m_planes = 1;
+		m_audioPattern = {};
+		m_pitch = 64;
+		m_hasAudioPattern = 0;
+
+		m_megaChip = 0;
+		m_megaIndices.clear();
+		m_megaPixels.clear();
+		m_megaFrame.clear();
+		m_palette.fill(0xFFFFFFFF);
+		m_palette[0] = 0;
+		m_spriteWidth = 0;
+		m_spriteHeight = 0;
+		m_screenAlpha = 0xFF;
+		m_blendMode = BlendMode::NORMAL;
+		m_collisionColor = 0;
+		m_sample = { .serial = m_sample.serial };
+
+		// Without a fixed seed every run gets a fresh one. Timers restart too, so a seeded run depends
+		// on nothing but the instructions executed and the keypad.
+		m_tick = 0;
+		m_playSound = 0;
+		semantics::seed_random(m_random, m_seed ? *m_seed : static_cast<uint64_t>(std::random_device{}()) << 32 | std::random_device{}());
 	}
-	auto Chip8::update(const ks::KeyboardInput& keyboard) -> void {
-		if (!m_releaseIt) {
-			if (!m_settings.changeKeypad) {
-				switch (keyboard.get_held_key()) {
-				case SDLK_X: m_cpu.key = 0; break;
-				case SDLK_1: m_cpu.key = 1; break;
-				case SDLK_2: m_cpu.key = 2; break;
-				case SDLK_3: m_cpu.key = 3; break;
-				case SDLK_Q: m_cpu.key = 4; break;
-				case SDLK_W: m_cpu.key = 5; break;
-				case SDLK_E: m_cpu.key = 6; break;
-				case SDLK_A: m_cpu.key = 7; break;
-				case SDLK_S: m_cpu.key = 8; break;
-				case SDLK_D: m_cpu.key = 9; break;
-				case SDLK_Z: m_cpu.key = 10; break;
-				case SDLK_C: m_cpu.key = 11; break;
-				case SDLK_4: m_cpu.key = 12; break;
-				case SDLK_R: m_cpu.key = 13; break;
-				case SDLK_F: m_cpu.key = 14; break;
-				case SDLK_V: m_cpu.key = 15; break;
-				default: m_cpu.key = -1; break;
-				}
+	auto Chip8::is_waiting_for_key() const -> bool {
+		if (m_cpu.halted || m_decoded[m_cpu.registers.PC & (CODE_SIZE - 1)].op != Opcode::WAIT_FOR_KEYPRESS) return 0;
+		return m_cpu.key < 0 ? m_cpu.keys == 0 : (m_cpu.keys >> m_cpu.key & 1);
+	}
+	auto Chip8::set_seed(const std::optional<uint64_t> seed) -> void {
+		m_seed = seed;
+		if (m_seed) semantics::seed_random(m_random, *m_seed);
+	}
+	auto Chip8::set_instructions_per_second(const int rate) -> void {
+		// The phase stays at the same point between two ticks.
+		const int32_t instructionsPerSecond = std::max(rate, 1);
+		m_tick = m_tick * instructionsPerSecond / m_instructionsPerSecond;
+		m_instructionsPerSecond = instructionsPerSecond;
+	}
+	auto Chip8::run_cycles(const int cycles, const uint16_t keypad) -> void {
+		m_cpu.keys = keypad;
+
+		if (m_cpu.halted) return;
+
+		(this->*m_run)(cycles);
+	}
+	auto Chip8::run_frame(const uint16_t keypad) -> void {
+		run_cycles(get_cycles_to_tick(), keypad);
+	}
+	auto Chip8::set_settings(const Settings& settings) -> void {
+		static constexpr auto runners = []<size_t... Profile>(std::index_sequence<Profile...>) {
+			return std::array<Runner, QUIRK_PROFILES>{ &Chip8::run<quirks_of(Profile)>... };
+			}(std::make_index_sequence<QUIRK_PROFILES>{});
+
+		const size_t profile = quirk_profile(settings);
+		if (m_jit && profile != quirk_profile(m_settings)) {
+			m_jit->flush();
+		}
+		m_settings = settings;
+		m_run = runners[profile];
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::run(const int cycles) -> void {
+		int remaining = cycles;
+		while (remaining > 0) {
+			if (const int idle = skip_idle<Q>(remaining)) {
+				advance(idle);
+				remaining -= idle;
+				continue;
 			}
-			else {
-				switch (keyboard.get_held_key()) {
-				case SDLK_1: m_cpu.key = 0; break;
-				case SDLK_2: m_cpu.key = 1; break;
-				case SDLK_3: m_cpu.key = 2; break;
-				case SDLK_4: m_cpu.key = 3; break;
-				case SDLK_Q: m_cpu.key = 4; break;
-				case SDLK_W: m_cpu.key = 5; break;
-				case SDLK_E: m_cpu.key = 6; break;
-				case SDLK_R: m_cpu.key = 7; break;
-				case SDLK_A: m_cpu.key = 8; break;
-				case SDLK_S: m_cpu.key = 9; break;
-				case SDLK_D: m_cpu.key = 10; break;
-				case SDLK_F: m_cpu.key = 11; break;
-				case SDLK_Z: m_cpu.key = 12; break;
-				case SDLK_X: m_cpu.key = 13; break;
-				case SDLK_C: m_cpu.key = 14; break;
-				case SDLK_V: m_cpu.key = 15; break;
-				default: m_cpu.key = -1; break;
-				}
+
+			// MEGA-CHIP needs the 24 bit I, which native code does not track.
+			int executed = 1;
+			switch (m_megaChip ? Engine::THREADED : m_engine) {
+			case Engine::SWITCH:
+				execute<Q>(fetch());
+				break;
+			case Engine::THREADED:
+				executed = execute_fused<Q>(remaining);
+				break;
+			case Engine::JIT:
+				executed = execute_jit<Q>(remaining);
+				break;
+			case Engine::RECOMPILED:
+				executed = execute_recompiled<Q>(remaining);
+				break;
 			}
+
+			advance(executed);
+			remaining -= executed;
+		}
+	}
+	auto Chip8::advance(const int cycles) -> void {
+		m_executedInstructions += cycles;
+
+		m_tick += static_cast<int64_t>(cycles) * TIMER_FREQUENCY;
+		if (m_tick < m_instructionsPerSecond) return;
+
+		const int ticks = static_cast<int>(std::min<int64_t>(m_tick / m_instructionsPerSecond, 0xFF));
+		m_tick %= m_instructionsPerSecond;
+
+		semantics::count_down(m_cpu.registers, ticks);
+
+		if (m_cpu.registers.sound != 0) {
+			m_playSound = 1;
 		}
 		else {
-			if (keyboard.get_held_key() == -1) {
-				m_released = 1;
-				m_releaseIt = 0;
-			}
+			m_playSound = 0;
 		}
+	}
+	// Returns how many instructions of the budget an idle loop at PC spends without changing anything
+	// but the timers. The caller advances the timers by that amount instead of stepping through it.
+	template<Chip8::Quirks Q>
+	auto Chip8::skip_idle(const int budget) -> int {
+		const uint16_t address = m_cpu.registers.PC & (CODE_SIZE - 1);
+		const Instruction& instruction = m_decoded[address];
 
-		if (!m_settings.changeKeypad) {
-			m_cpu.keys[0] = keyboard.is_key_held(SDLK_X);
-			m_cpu.keys[1] = keyboard.is_key_held(SDLK_1);
-			m_cpu.keys[2] = keyboard.is_key_held(SDLK_2);
-			m_cpu.keys[3] = keyboard.is_key_held(SDLK_3);
-			m_cpu.keys[4] = keyboard.is_key_held(SDLK_Q);
-			m_cpu.keys[5] = keyboard.is_key_held(SDLK_W);
-			m_cpu.keys[6] = keyboard.is_key_held(SDLK_E);
-			m_cpu.keys[7] = keyboard.is_key_held(SDLK_A);
-			m_cpu.keys[8] = keyboard.is_key_held(SDLK_S);
-			m_cpu.keys[9] = keyboard.is_key_held(SDLK_D);
-			m_cpu.keys[10] = keyboard.is_key_held(SDLK_Z);
-			m_cpu.keys[11] = keyboard.is_key_held(SDLK_C);
-			m_cpu.keys[12] = keyboard.is_key_held(SDLK_4);
-			m_cpu.keys[13] = keyboard.is_key_held(SDLK_R);
-			m_cpu.keys[14] = keyboard.is_key_held(SDLK_F);
-			m_cpu.keys[15] = keyboard.is_key_held(SDLK_V);
+		// The VIP draws during the vertical blank, a DXYN anywhere else in the frame waits for the next one.
+		// Every path that runs more than one instruction at a time leaves draws to this, so the wait
+		// always starts here. A tick leaves less than one instruction of phase, which is the blank.
+		if (Q.displayWait && instruction.op == Opcode::DRAW && !m_highResolution && !m_megaChip && m_tick >= TIMER_FREQUENCY) {
+			m_cpu.registers.PC = address;
+			return std::min(budget, get_cycles_to_tick());
 		}
-		else {
-			m_cpu.keys[0] = keyboard.is_key_held(SDLK_1);
-			m_cpu.keys[1] = keyboard.is_key_held(SDLK_2);
-			m_cpu.keys[2] = keyboard.is_key_held(SDLK_3);
-			m_cpu.keys[3] = keyboard.is_key_held(SDLK_4);
-			m_cpu.keys[4] = keyboard.is_key_held(SDLK_Q);
-			m_cpu.keys[5] = keyboard.is_key_held(SDLK_W);
-			m_cpu.keys[6] = keyboard.is_key_held(SDLK_E);
-			m_cpu.keys[7] = keyboard.is_key_held(SDLK_R);
-			m_cpu.keys[8] = keyboard.is_key_held(SDLK_A);
-			m_cpu.keys[9] = keyboard.is_key_held(SDLK_S);
-			m_cpu.keys[10] = keyboard.is_key_held(SDLK_D);
-			m_cpu.keys[11] = keyboard.is_key_held(SDLK_F);
-			m_cpu.keys[12] = keyboard.is_key_held(SDLK_Z);
-			m_cpu.keys[13] = keyboard.is_key_held(SDLK_X);
-			m_cpu.keys[14] = keyboard.is_key_held(SDLK_C);
-			m_cpu.keys[15] = keyboard.is_key_held(SDLK_V);
 
+		// The display wait is part of what DXYN does, everything below only saves time.
+		if (!m_idleSkipping) return 0;
+
+		if (instruction.fusion == Fusion::DELAY_WAIT) {
+			// FX07, 3XNN, 1NNN back to FX07. While an iteration is shorter than a tick the timer drops by at
+			// most one between reads, and the first read of NN is at the first iteration that starts after
+			// delay - NN ticks. Slower rates are stepped through.
+			if (3 * TIMER_FREQUENCY > m_instructionsPerSecond) return 0;
+
+			const Instruction& skip = m_decoded[(address + 2) & (CODE_SIZE - 1)];
+			const int delay = m_cpu.registers.delay;
+			int iterations = budget / 3;
+			if (skip.literal <= delay) {
+				iterations = std::min(iterations, (get_cycles_to_ticks(delay - skip.literal) + 2) / 3);
+			}
+			if (iterations == 0) return 0;
+
+			const int ticks = static_cast<int>((m_tick + 3 * TIMER_FREQUENCY * static_cast<int64_t>(iterations - 1)) / m_instructionsPerSecond);
+			m_cpu.registers.set_register(skip.vx, static_cast<uint8_t>(std::max(delay - ticks, 0)));
+			m_cpu.registers.PC = address;
+			m_delayWaitInstructions += iterations * 3;
+			return iterations * 3;
 		}
 
-		if (m_cpu.halted) return;
+		if (instruction.op == Opcode::WAIT_FOR_KEYPRESS) {
+			// The keypad is latched for the batch, so a wait that repeats once repeats for all of it.
+			if (m_cpu.key >= 0 && !(m_cpu.keys >> m_cpu.key & 1)) return 0;
+			if (m_cpu.key < 0 && m_cpu.keys) m_cpu.key = static_cast<int8_t>(std::countr_zero(m_cpu.keys));
+			m_cpu.registers.PC = address;
+			return budget;
+		}
 
-		const uint16_t opcode = fetch();
-		const Instruction instruction = decode(opcode);
-		execute(instruction);
+		// 00FD halts the interpreter and then keeps repeating itself.
+		if (instruction.op == Opcode::EXIT) {
+			m_cpu.halted = 1;
+			m_cpu.registers.PC = address;
+			return budget;
+		}
 
-		m_tick++;
-		if (m_tick >= 9) {
-			m_tick = 0;
+		if (instruction.op == Opcode::JP && instruction.address == address) {
+			m_cpu.registers.PC = address;
+			return budget;
+		}
+		return 0;
+	}
+	auto Chip8::fetch() -> Instruction {
+		const Instruction instruction = m_decoded[m_cpu.registers.PC & (CODE_SIZE - 1)];
+		m_cpu.registers.PC = (m_cpu.registers.PC + 2) & 0xFFF;
+		return instruction;
+	}
+	auto Chip8::predecode(std::span<Instruction, CODE_SIZE> decoded, const uint8_t* ram, const uint16_t address) -> void {
+		const uint16_t opcode = ram[address] << 8 | ram[(address + 1) & (CODE_SIZE - 1)];
+		decoded[address] = decode(opcode);
+	}
+	auto Chip8::fuse(std::span<Instruction, CODE_SIZE> decoded, const uint16_t address) -> void {
+		Instruction& first = decoded[address];
+		const Instruction& second = decoded[(address + 2) & (CODE_SIZE - 1)];
+		const Instruction& third = decoded[(address + 4) & (CODE_SIZE - 1)];
 
-			if (m_cpu.registers.delay > 0) m_cpu.registers.delay--;
-			if (m_cpu.registers.sound > 0) m_cpu.registers.sound--;
+		first.fusion = [&]() -> Fusion {
+			switch (first.op) {
+				using enum Opcode;
+			case SET_VX_TO_DELAY:
+				return semantics::is_delay_wait(address, first, second, third) ? Fusion::DELAY_WAIT : Fusion::NONE;
+			case VX_SET:
+				return second.op == VX_SET ? Fusion::LOAD_PAIR : Fusion::NONE;
+			case SET_I:
+				return second.op == DRAW ? Fusion::SET_I_AND_DRAW : Fusion::NONE;
+			case SKIP_VX_EQ_NN:
+			case SKIP_VX_NEQ_NN:
+			case SKIP_VX_EQ_VY:
+			case SKIP_VX_NEQ_VY:
+				return second.op == JP ? Fusion::SKIP_JUMP : Fusion::NONE;
+			default:
+				return Fusion::NONE;
+			}
+			}();
+	}
+	auto Chip8::write_memory(const uint32_t address, const uint8_t value) -> void {
+		m_RAM[address] = value;
+		if (address < RAM_GUARD) {
+			m_RAM[m_ramMask + 1 + address] = value;
+		}
+		// Data above the code window needs no bookkeeping, which is where XO-CHIP programs keep most of it.
+		if (address >= CODE_SIZE) return;
 
-			if (m_cpu.registers.sound != 0) {
-				m_playSound = 1;
+		// Self-modifying code: both instructions overlapping the byte are stale now, in a table of this
+		// instance's own.
+		if (!m_ownDecoded) {
+			m_ownDecoded = std::make_unique<std::array<Instruction, CODE_SIZE>>();
+			std::copy_n(m_decoded, CODE_SIZE, m_ownDecoded->begin());
+			m_decoded = m_ownDecoded->data();
+		}
+		predecode(*m_ownDecoded, m_RAM.data(), address);
+		predecode(*m_ownDecoded, m_RAM.data(), (address - 1) & (CODE_SIZE - 1));
+		// Fused sequences are at most three instructions long.
+		for (int offset = 0; offset <= 5; offset++) {
+			fuse(*m_ownDecoded, (address - offset) & (CODE_SIZE - 1));
+		}
+		// So are translated skips right before the byte, their target depends on whether it is F000.
+		if (m_jit) {
+			m_jit->invalidate(address);
+			m_jit->invalidate((address - 2) & (CODE_SIZE - 1));
+		}
+		if (!m_recompiledBlocks.empty()) {
+			for (int offset = 0; offset < Jit::MAX_BLOCK_LENGTH * 2 + 2; offset++) {
+				const RecompiledBlock*& block = m_recompiledBlocks[(address - offset) & (CODE_SIZE - 1)];
+				if (block && offset < block->length * 2 + 2) {
+					block = nullptr;
+				}
 			}
-			else {
-				m_playSound = 0;
+		}
+	}
+	auto Chip8::restore(const BootSnapshot& snapshot) -> void {
+		// Bytes the boot sequence wrote go through write_memory, so every engine sees them.
+		for (int address = 0; address < CODE_SIZE; address++) {
+			if (m_RAM[address] != snapshot.ram[address]) {
+				write_memory(address, snapshot.ram[address]);
 			}
 		}
+		m_cpu = snapshot.cpu;
+		m_displayMemory[0] = snapshot.display;
+		m_tick = snapshot.tick;
+		m_playSound = snapshot.playSound;
+		m_executedInstructions += snapshot.executed;
+		m_delayWaitInstructions += snapshot.delayWait;
 	}
-	auto Chip8::fetch() -> uint16_t {
-		const uint16_t instruction = m_RAM[m_cpu.registers.PC] << 8 | m_RAM[m_cpu.registers.PC + 1];
-		m_cpu.registers.PC = (m_cpu.registers.PC + 2) & 0xFFF;
-		return instruction;
+	auto Chip8::skip() -> void {
+		// F000 NNNN and 01NN NNNN are four bytes long and are skipped as a whole.
+		const Opcode next = m_decoded[m_cpu.registers.PC & (CODE_SIZE - 1)].op;
+		const bool isLong = next == Opcode::SET_I_LONG || (next == Opcode::SET_I_MEGA && m_megaChip);
+		m_cpu.registers.PC += isLong ? 4 : 2;
 	}
-	auto Chip8::decode(const uint16_t opcode) -> Instruction {
-		const uint8_t n1 = (opcode >> 12) & 0xF;
-		const uint8_t n2 = (opcode >> 8) & 0xF;
-		const uint8_t n3 = (opcode >> 4) & 0xF;
-		const uint8_t n4 = (opcode) & 0xF;
-		const uint8_t n34 = opcode & 0xFF;
+	template<Chip8::Quirks Q>
+	auto Chip8::execute_fused(const int budget) -> int {
+		static constexpr auto handlers = []() {
+			std::array<FusedHandler, static_cast<size_t>(Fusion::COUNT)> table{};
+			table[static_cast<size_t>(Fusion::DELAY_WAIT)] = &Chip8::fused_delay_wait;
+			table[static_cast<size_t>(Fusion::LOAD_PAIR)] = &Chip8::fused_load_pair;
+			table[static_cast<size_t>(Fusion::SET_I_AND_DRAW)] = &Chip8::fused_set_i_and_draw<Q>;
+			table[static_cast<size_t>(Fusion::SKIP_JUMP)] = &Chip8::fused_skip_jump<Q>;
+			return table;
+			}();
+		// Instructions a fused handler may execute, it is only entered if all of them fit in the budget.
+		static constexpr std::array<int, static_cast<size_t>(Fusion::COUNT)> lengths{ 1, 3, 2, 2, 2 };
 
-		Instruction instruction;
-		instruction.type = static_cast<InstructionType>(n1);
-		instruction.vx = n2;
-		instruction.vy = n3;
-		instruction.address = opcode & 0x0FFF;
+		const uint16_t address = m_cpu.registers.PC & (CODE_SIZE - 1);
+		const Fusion fusion = m_decoded[address].fusion;
+		if (fusion == Fusion::NONE || lengths[static_cast<size_t>(fusion)] > budget || (Q.displayWait && fusion == Fusion::SET_I_AND_DRAW)) {
+			execute_threaded<Q>(fetch());
+			return 1;
+		}
 
-		if (instruction.type == InstructionType::ZERO && n2 == 0) {
-			instruction.zeroType = static_cast<ZeroType>(n34);
+		return (this->*handlers[static_cast<size_t>(fusion)])(address);
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::execute_jit(const int budget) -> int {
+		if (!m_jit) {
+			m_jit = std::make_unique<Jit>(Jit::Layout{
+				.V = offsetof(CPU::Registers, V),
+				.PC = offsetof(CPU::Registers, PC),
+				.I = offsetof(CPU::Registers, I),
+				.delay = offsetof(CPU::Registers, delay),
+				.sound = offsetof(CPU::Registers, sound),
+			});
 		}
-		else if (instruction.type == InstructionType::ARITHMETIC) {
-			instruction.arithmeticType = static_cast<ArithmeticType>(n4);
+
+		// Delay waits run fused so they are counted, blocks end in front of them.
+		const uint16_t address = m_cpu.registers.PC & (CODE_SIZE - 1);
+		if (m_decoded[address].fusion == Fusion::DELAY_WAIT) {
+			return execute_fused<Q>(budget);
 		}
-		else if (instruction.type == InstructionType::MISC) {
-			instruction.miscType = static_cast<MiscType>(n34);
+
+		const Jit::Block* block = &m_jit->find(address);
+		if (!block->translated) {
+			block = &m_jit->translate(address, std::span<const uint8_t, CODE_SIZE>(m_RAM.data(), CODE_SIZE), std::span<const Instruction, CODE_SIZE>(m_decoded, CODE_SIZE), &Chip8::interpret<Q>, Q.putVYintoVXbeforeShift);
 		}
-		else if (instruction.type == InstructionType::KEY) {
-			instruction.keyType = static_cast<KeyType>(n34);
+
+		// Blocks run to completion, so they are only entered when the whole block fits in the budget
+		// and no timer tick is due before their last timer access.
+		if (!block->code || block->length > budget || block->timerIndex >= get_cycles_to_tick() || (Q.displayWait && block->drawIndex >= 0)) {
+			execute_threaded<Q>(fetch());
+			return 1;
 		}
-		else {
-			instruction.literal = n34;
+
+		block->code(this, reinterpret_cast<uint8_t*>(&m_cpu.registers));
+		return block->length;
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::execute_recompiled(const int budget) -> int {
+		const uint16_t address = m_cpu.registers.PC & (CODE_SIZE - 1);
+		if (m_decoded[address].fusion == Fusion::DELAY_WAIT) {
+			return execute_fused<Q>(budget);
 		}
+		const RecompiledBlock* block = m_recompiledBlocks.empty() ? nullptr : m_recompiledBlocks[address];
 
-		return instruction;
+		// Computed jumps, self-modified code and code the recompiler never reached are interpreted.
+		if (!block || block->length > budget || block->timerIndex >= get_cycles_to_tick() || (Q.displayWait && block->drawIndex >= 0)) {
+			execute_threaded<Q>(fetch());
+			return 1;
+		}
+
+		RecompiledContext context{
+			.cpu = m_cpu,
+			.ram = m_RAM.data(),
+			.chip8 = this,
+			.interpret = &Chip8::interpret<Q>,
+			.shiftUsesVY = Q.putVYintoVXbeforeShift,
+		};
+		block->run(context);
+		return block->length;
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::interpret(void* context, const uint32_t opcode) -> void {
+		Chip8& chip8 = *static_cast<Chip8*>(context);
+		chip8.execute_threaded<Q>(chip8.decode(static_cast<uint16_t>(opcode)));
 	}
+	template<Chip8::Quirks Q>
 	auto Chip8::execute(const Instruction instruction) -> void {
 		auto print_warning = [](const std::string_view type, const uint8_t value) -> void {
 			std::cerr << std::format("[{}] Unknown instruction {:#04x}.\n", type, value);
 		};
 
+		auto execute_mega = [&](const Instruction instruction) -> void {
+			switch (instruction.vx) {
+			case 0x1:
+				op_set_i_mega(instruction);
+				break;
+			case 0x2:
+				op_load_palette(instruction);
+				break;
+			case 0x3:
+				op_set_sprite_width(instruction);
+				break;
+			case 0x4:
+				op_set_sprite_height(instruction);
+				break;
+			case 0x5:
+				op_set_screen_alpha(instruction);
+				break;
+			case 0x6:
+				if (instruction.vy == 0) op_play_sample(instruction);
+				break;
+			case 0x7:
+				if (instruction.literal == 0) op_stop_sample(instruction);
+				break;
+			case 0x8:
+				if (instruction.vy == 0) op_set_blend_mode(instruction);
+				break;
+			case 0x9:
+				op_set_collision_color(instruction);
+				break;
+			default:
+				// ignore 0NNN
+				break;
+			}
+			};
+
 		auto execute_zero = [&](const Instruction instruction) -> void {
+			if (instruction.vx != 0) {
+				execute_mega(instruction);
+				return;
+			}
+
 			switch (instruction.zeroType) {
 				using enum ZeroType;
 			case NOT_IMPORTANT: break;
+			case MEGA_OFF:
+				op_mega_off(instruction);
+				break;
+			case MEGA_ON:
+				op_mega_on(instruction);
+				break;
 			case CLEAR:
-				m_displayMemory = {};
+				op_clear(instruction);
 				break;
 			case RET:
-				m_cpu.registers.PC = m_cpu.stack.pop();
+				op_ret(instruction);
+				break;
+			case SCROLL_RIGHT:
+				op_scroll_right(instruction);
+				break;
+			case SCROLL_LEFT:
+				op_scroll_left(instruction);
+				break;
+			case EXIT:
+				op_exit(instruction);
+				break;
+			case LOW_RES:
+				op_low_res(instruction);
+				break;
+			case HIGH_RES:
+				op_high_res(instruction);
 				break;
 			default:
+				if ((instruction.literal & 0xF0) == 0xC0) {
+					op_scroll_down(instruction);
+				}
+				else if ((instruction.literal & 0xF0) == 0xB0 || (instruction.literal & 0xF0) == 0xD0) {
+					op_scroll_up(instruction);
+				}
 				// ignore 0NNN
 				break;
 			}
 			};
 		auto execute_arithmetic = [&](const Instruction instruction) -> void {
-			const uint8_t vxValue = m_cpu.registers.get_register(instruction.vx);
-			const uint8_t vyValue = m_cpu.registers.get_register(instruction.vy);
 			switch (instruction.arithmeticType) {
 				using enum ArithmeticType;
 			case SET_VX_TO_VY:
-				m_cpu.registers.set_register(instruction.vx, vyValue);
+				op_set_vx_to_vy(instruction);
 				break;
 			case OR_VX_WITH_VY:
-				m_cpu.registers.set_register(instruction.vx, vxValue | vyValue);
+				op_or_vx_with_vy(instruction);
 				break;
 			case AND_VX_WITH_VY:
-				m_cpu.registers.set_register(instruction.vx, vxValue & vyValue);
+				op_and_vx_with_vy(instruction);
 				break;
 			case XOR_VX_WITH_VY:
-				m_cpu.registers.set_register(instruction.vx, vxValue ^ vyValue);
+				op_xor_vx_with_vy(instruction);
+				break;
+			case ADD_VY_TO_VX:
+				op_add_vy_to_vx(instruction);
+				break;
+			case SUB_VY_FROM_VX:
+				op_sub_vy_from_vx(instruction);
 				break;
-			case ADD_VY_TO_VX: {
-				const uint16_t sum = static_cast<uint16_t>(vxValue) + static_cast<uint16_t>(vyValue);
-				m_cpu.registers.set_register(instruction.vx, sum & 0xFF);
-				if (sum > 255) {
-					m_cpu.registers.V[0xF] = 1;
-				}
-				else {
-					m_cpu.registers.V[0xF] = 0;
-				}
-			}	break;
-			case SUB_VY_FROM_VX: {
-				m_cpu.registers.set_register(instruction.vx, vxValue - vyValue);
-				if (vxValue >= vyValue) {
-					m_cpu.registers.V[0xF] = 1;
-				}
-				else {
-					m_cpu.registers.V[0xF] = 0;
-				}
-			}	break;
 			case SR_VX_BY_VY:
-				if (m_settings.putVYintoVXbeforeShift) {
-					m_cpu.registers.set_register(instruction.vx, vyValue >> 1);
-					m_cpu.registers.V[0xF] = vyValue & 0x1;
-				}
-				else {
-					m_cpu.registers.set_register(instruction.vx, vxValue >> 1);
-					m_cpu.registers.V[0xF] = vxValue & 0x1;
-				}
+				op_sr_vx_by_vy<Q>(instruction);
 				break;
 			case SUB_VX_FROM_VY:
-				m_cpu.registers.set_register(instruction.vx, vyValue - vxValue);
-				if (vyValue >= vxValue) {
-					m_cpu.registers.V[0xF] = 1;
-				}
-				else {
-					m_cpu.registers.V[0xF] = 0;
-				}
+				op_sub_vx_from_vy(instruction);
 				break;
 			case SL_VX_BY_VY:
-				if (m_settings.putVYintoVXbeforeShift) {
-					m_cpu.registers.set_register(instruction.vx, vyValue << 1);
-					m_cpu.registers.V[0xF] = (vyValue & 0x80) >> 7;
-				}
-				else {
-					m_cpu.registers.set_register(instruction.vx, vxValue << 1);
-					m_cpu.registers.V[0xF] = (vxValue & 0x80) >> 7;
-				}
+				op_sl_vx_by_vy<Q>(instruction);
 				break;
 			default:
 				print_warning("ARITHMETIC", static_cast<uint8_t>(instruction.arithmeticType));
@@ -305,14 +577,13 @@ namespace ks {
 			}
 			};
 		auto execute_key = [&](const Instruction instruction) -> void {
-			const uint8_t vxValue = m_cpu.registers.get_register(instruction.vx) & 0xF;
 			switch (instruction.keyType) {
 				using enum KeyType;
 			case KEY_PRESSED:
-				if (m_cpu.keys[vxValue]) m_cpu.registers.PC += 2;
+				op_key_pressed(instruction);
 				break;
 			case KEY_NOT_PRESSED:
-				if (!m_cpu.keys[vxValue]) m_cpu.registers.PC += 2;
+				op_key_not_pressed(instruction);
 				break;
 			default:
 				print_warning("KEY", static_cast<uint8_t>(instruction.keyType));
@@ -323,57 +594,52 @@ namespace ks {
 			switch (instruction.miscType) {
 				using enum MiscType;
 			case SET_VX_TO_DELAY:
-				m_cpu.registers.set_register(instruction.vx, m_cpu.registers.delay);
+				op_set_vx_to_delay(instruction);
 				break;
 			case WAIT_FOR_KEYPRESS:
-				if (m_cpu.key == -1) m_cpu.registers.PC -= 2;
-				else {
-					if (m_released) {
-						m_cpu.registers.set_register(instruction.vx, m_cpu.key);
-						m_released = 0;
-					}
-					else {
-						m_releaseIt = 1;
-						m_cpu.registers.PC -= 2;
-					}
-				}
+				op_wait_for_keypress(instruction);
 				break;
 			case SET_DELAY_TO_VX:
-				m_cpu.registers.delay = m_cpu.registers.get_register(instruction.vx);
+				op_set_delay_to_vx(instruction);
 				break;
 			case SET_SOUND_TO_VX:
-				m_cpu.registers.sound = m_cpu.registers.get_register(instruction.vx);
+				op_set_sound_to_vx(instruction);
 				break;
 			case ADD_VX_TO_I:
-				m_cpu.registers.I += m_cpu.registers.get_register(instruction.vx);
-				if (m_cpu.registers.I > 0xFFF) {
-					// Spacefight 2091! relies on this behavior.
-					m_cpu.registers.V[0xF] = 1;
-				}
+				op_add_vx_to_i(instruction);
 				break;
 			case SET_I_TO_HEX_CHARACTER:
-				m_cpu.registers.I = 0x50 + (m_cpu.registers.get_register(instruction.vx) & 0xF) * 5;
+				op_set_i_to_hex_character(instruction);
 				break;
 			case BCD_VX:
-				m_RAM[m_cpu.registers.I] = m_cpu.registers.get_register(instruction.vx) / 100;
-				m_RAM[m_cpu.registers.I + 1] = (m_cpu.registers.get_register(instruction.vx) / 10) % 10;
-				m_RAM[m_cpu.registers.I + 2] = m_cpu.registers.get_register(instruction.vx) % 10;
+				op_bcd_vx(instruction);
 				break;
 			case SAVE_VX:
-				for (int i = 0; i <= instruction.vx; i++) {
-					m_RAM[m_cpu.registers.I + i] = m_cpu.registers.V[i];
-				}
-				if (m_settings.changeValueOfI) {
-					m_cpu.registers.I += instruction.vx + 1;
-				}
+				op_save_vx<Q>(instruction);
 				break;
 			case LOAD_VX:
-				for (int i = 0; i <= instruction.vx; i++) {
-					m_cpu.registers.V[i] = m_RAM[m_cpu.registers.I + i];
-				}
-				if (m_settings.changeValueOfI) {
-					m_cpu.registers.I += instruction.vx + 1;
-				}
+				op_load_vx<Q>(instruction);
+				break;
+			case SET_I_TO_BIG_CHARACTER:
+				op_set_i_to_big_character(instruction);
+				break;
+			case SAVE_FLAGS:
+				op_save_flags(instruction);
+				break;
+			case LOAD_FLAGS:
+				op_load_flags(instruction);
+				break;
+			case SET_I_LONG:
+				op_set_i_long(instruction);
+				break;
+			case SELECT_PLANES:
+				op_select_planes(instruction);
+				break;
+			case LOAD_AUDIO_PATTERN:
+				op_load_audio_pattern(instruction);
+				break;
+			case SET_PITCH_TO_VX:
+				op_set_pitch_to_vx(instruction);
 				break;
 			default:
 				print_warning("MISC", static_cast<uint8_t>(instruction.miscType));
@@ -387,84 +653,54 @@ namespace ks {
 			execute_zero(instruction);
 			break;
 		case JP:
-			m_cpu.registers.PC = instruction.address;
+			op_jp(instruction);
 			break;
 		case CALL:
-			m_cpu.stack.push(m_cpu.registers.PC);
-			m_cpu.registers.PC = instruction.address;
+			op_call(instruction);
 			break;
 		case SKIP_VX_EQ_NN:
-			if (m_cpu.registers.get_register(instruction.vx) == instruction.literal) {
-				m_cpu.registers.PC += 2;
-			}
+			op_skip_vx_eq_nn(instruction);
 			break;
 		case SKIP_VX_NEQ_NN:
-			if (m_cpu.registers.get_register(instruction.vx) != instruction.literal) {
-				m_cpu.registers.PC += 2;
-			}
+			op_skip_vx_neq_nn(instruction);
 			break;
 		case SKIP_VX_NEQ_VY:
-			if (m_cpu.registers.get_register(instruction.vx) == m_cpu.registers.get_register(instruction.vy)) {
-				m_cpu.registers.PC += 2;
+			switch (instruction.rangeType) {
+			case RangeType::SAVE_VX_TO_VY:
+				op_save_vx_to_vy(instruction);
+				break;
+			case RangeType::LOAD_VX_TO_VY:
+				op_load_vx_to_vy(instruction);
+				break;
+			default:
+				op_skip_vx_eq_vy(instruction);
+				break;
 			}
 			break;
 		case VX_SET:
-			m_cpu.registers.set_register(instruction.vx, instruction.literal);
+			op_vx_set(instruction);
 			break;
 		case VX_ADD:
-			m_cpu.registers.set_register(
-				instruction.vx,
-				m_cpu.registers.get_register(instruction.vx) + instruction.literal);
+			op_vx_add(instruction);
 			break;
 		case ARITHMETIC:
 			execute_arithmetic(instruction);
 			break;
 		case SKIP_VX_EQ_VY:
-			if (m_cpu.registers.get_register(instruction.vx) != m_cpu.registers.get_register(instruction.vy)) {
-				m_cpu.registers.PC += 2;
-			}
+			op_skip_vx_neq_vy(instruction);
 			break;
 		case SET_I:
-			m_cpu.registers.I = instruction.address;
+			op_set_i(instruction);
 			break;
 		case JR:
-			if (m_settings.useVXinsteadOfV0) {
-				m_cpu.registers.PC = instruction.address + m_cpu.registers.V[instruction.vx];
-			}
-			else {
-				m_cpu.registers.PC = instruction.address + m_cpu.registers.V[0];
-			}
+			op_jr<Q>(instruction);
 			break;
 		case RANDOM:
-			m_cpu.registers.set_register(instruction.vx, ks::random(0, 255) & instruction.literal);
+			op_random(instruction);
+			break;
+		case DRAW:
+			op_draw<Q>(instruction);
 			break;
-		case DRAW: {
-			const uint8_t x = m_cpu.registers.get_register(instruction.vx) & (DISPLAY_X - 1);
-			const uint8_t y = m_cpu.registers.get_register(instruction.vy) & (DISPLAY_Y - 1);
-			m_cpu.registers.V[0xF] = 0;
-
-			for (int i = 0; i < (instruction.literal & 0xF); i++) {
-				const uint8_t b = m_RAM[m_cpu.registers.I + i];
-				for (int j = 0; j < 8; j++) {
-					uint8_t rx = x + j;
-					uint8_t ry = y + i;
-					if (m_settings.clipping) {
-						if (rx >= DISPLAY_X || ry >= DISPLAY_Y) break;
-					}
-					else {
-						rx &= (DISPLAY_X - 1);
-						ry &= (DISPLAY_Y - 1);
-					}
-					const bool bitIndex = ((0x80u >> j) & b) >> (7 - j);
-					if (bitIndex) {
-						if (m_displayMemory[rx][ry]) {
-							m_cpu.registers.V[0xF] = 1;
-						}
-						m_displayMemory[rx][ry] ^= bitIndex;
-					}
-				}
-			}
-		}	break;
 		case KEY:
 			execute_key(instruction);
 			break;
@@ -476,4 +712,607 @@ namespace ks {
 			break;
 		}
 	}
+	template<Chip8::Quirks Q>
+	auto Chip8::execute_threaded(const Instruction instruction) -> void {
+		static constexpr auto handlers = []() {
+			std::array<Handler, static_cast<size_t>(Opcode::COUNT)> table{};
+			auto set = [&](const Opcode op, const Handler handler) -> void {
+				table[static_cast<size_t>(op)] = handler;
+			};
+
+			using enum Opcode;
+			set(UNKNOWN, &Chip8::op_unknown);
+			set(NOP, &Chip8::op_nop);
+			set(CLEAR, &Chip8::op_clear);
+			set(RET, &Chip8::op_ret);
+			set(JP, &Chip8::op_jp);
+			set(CALL, &Chip8::op_call);
+			set(SKIP_VX_EQ_NN, &Chip8::op_skip_vx_eq_nn);
+			set(SKIP_VX_NEQ_NN, &Chip8::op_skip_vx_neq_nn);
+			set(SKIP_VX_EQ_VY, &Chip8::op_skip_vx_eq_vy);
+			set(VX_SET, &Chip8::op_vx_set);
+			set(VX_ADD, &Chip8::op_vx_add);
+			set(SET_VX_TO_VY, &Chip8::op_set_vx_to_vy);
+			set(OR_VX_WITH_VY, &Chip8::op_or_vx_with_vy);
+			set(AND_VX_WITH_VY, &Chip8::op_and_vx_with_vy);
+			set(XOR_VX_WITH_VY, &Chip8::op_xor_vx_with_vy);
+			set(ADD_VY_TO_VX, &Chip8::op_add_vy_to_vx);
+			set(SUB_VY_FROM_VX, &Chip8::op_sub_vy_from_vx);
+			set(SR_VX_BY_VY, &Chip8::op_sr_vx_by_vy<Q>);
+			set(SUB_VX_FROM_VY, &Chip8::op_sub_vx_from_vy);
+			set(SL_VX_BY_VY, &Chip8::op_sl_vx_by_vy<Q>);
+			set(SKIP_VX_NEQ_VY, &Chip8::op_skip_vx_neq_vy);
+			set(SET_I, &Chip8::op_set_i);
+			set(JR, &Chip8::op_jr<Q>);
+			set(RANDOM, &Chip8::op_random);
+			set(DRAW, &Chip8::op_draw<Q>);
+			set(KEY_PRESSED, &Chip8::op_key_pressed);
+			set(KEY_NOT_PRESSED, &Chip8::op_key_not_pressed);
+			set(SET_VX_TO_DELAY, &Chip8::op_set_vx_to_delay);
+			set(WAIT_FOR_KEYPRESS, &Chip8::op_wait_for_keypress);
+			set(SET_DELAY_TO_VX, &Chip8::op_set_delay_to_vx);
+			set(SET_SOUND_TO_VX, &Chip8::op_set_sound_to_vx);
+			set(ADD_VX_TO_I, &Chip8::op_add_vx_to_i);
+			set(SET_I_TO_HEX_CHARACTER, &Chip8::op_set_i_to_hex_character);
+			set(BCD_VX, &Chip8::op_bcd_vx);
+			set(SAVE_VX, &Chip8::op_save_vx<Q>);
+			set(LOAD_VX, &Chip8::op_load_vx<Q>);
+			set(SCROLL_DOWN, &Chip8::op_scroll_down);
+			set(SCROLL_RIGHT, &Chip8::op_scroll_right);
+			set(SCROLL_LEFT, &Chip8::op_scroll_left);
+			set(EXIT, &Chip8::op_exit);
+			set(LOW_RES, &Chip8::op_low_res);
+			set(HIGH_RES, &Chip8::op_high_res);
+			set(SET_I_TO_BIG_CHARACTER, &Chip8::op_set_i_to_big_character);
+			set(SAVE_FLAGS, &Chip8::op_save_flags);
+			set(LOAD_FLAGS, &Chip8::op_load_flags);
+			set(SET_I_LONG, &Chip8::op_set_i_long);
+			set(SELECT_PLANES, &Chip8::op_select_planes);
+			set(SAVE_VX_TO_VY, &Chip8::op_save_vx_to_vy);
+			set(LOAD_VX_TO_VY, &Chip8::op_load_vx_to_vy);
+			set(LOAD_AUDIO_PATTERN, &Chip8::op_load_audio_pattern);
+			set(SET_PITCH_TO_VX, &Chip8::op_set_pitch_to_vx);
+			set(MEGA_OFF, &Chip8::op_mega_off);
+			set(MEGA_ON, &Chip8::op_mega_on);
+			set(SCROLL_UP, &Chip8::op_scroll_up);
+			set(SET_I_MEGA, &Chip8::op_set_i_mega);
+			set(LOAD_PALETTE, &Chip8::op_load_palette);
+			set(SET_SPRITE_WIDTH, &Chip8::op_set_sprite_width);
+			set(SET_SPRITE_HEIGHT, &Chip8::op_set_sprite_height);
+			set(SET_SCREEN_ALPHA, &Chip8::op_set_screen_alpha);
+			set(PLAY_SAMPLE, &Chip8::op_play_sample);
+			set(STOP_SAMPLE, &Chip8::op_stop_sample);
+			set(SET_BLEND_MODE, &Chip8::op_set_blend_mode);
+			set(SET_COLLISION_COLOR, &Chip8::op_set_collision_color);
+			return table;
+			}();
+
+		(this->*handlers[static_cast<size_t>(instruction.op)])(instruction);
+	}
+
+	auto Chip8::op_unknown(const Instruction instruction) -> void {
+		const auto [type, value] = [&]() -> std::pair<std::string_view, uint8_t> {
+			switch (instruction.type) {
+			case InstructionType::ARITHMETIC: return { "ARITHMETIC", static_cast<uint8_t>(instruction.arithmeticType) };
+			case InstructionType::KEY: return { "KEY", static_cast<uint8_t>(instruction.keyType) };
+			case InstructionType::MISC: return { "MISC", static_cast<uint8_t>(instruction.miscType) };
+			default: return { "DEFAULT", static_cast<uint8_t>(instruction.type) };
+			}
+			}();
+		std::cerr << std::format("[{}] Unknown instruction {:#04x}.\n", type, value);
+	}
+	auto Chip8::op_nop(const Instruction instruction) -> void {
+	}
+	auto Chip8::op_clear(const Instruction instruction) -> void {
+		if (m_megaChip) {
+			// 00E0 ends a MEGA-CHIP frame: what was drawn is shown and drawing starts over.
+			std::swap(m_megaFrame, m_megaPixels);
+			std::fill(m_megaPixels.begin(), m_megaPixels.end(), 0);
+			std::fill(m_megaIndices.begin(), m_megaIndices.end(), 0);
+			m_megaFrameCount++;
+			return;
+		}
+		for (int plane = 0; plane < PLANES; plane++) {
+			if (m_planes >> plane & 1) m_displayMemory[plane] = {};
+		}
+	}
+	auto Chip8::op_ret(const Instruction instruction) -> void {
+		m_cpu.registers.PC = m_cpu.stack.pop();
+	}
+	auto Chip8::op_jp(const Instruction instruction) -> void {
+		m_cpu.registers.PC = instruction.address;
+	}
+	auto Chip8::op_call(const Instruction instruction) -> void {
+		m_cpu.stack.push(m_cpu.registers.PC);
+		m_cpu.registers.PC = instruction.address;
+	}
+	auto Chip8::op_skip_vx_eq_nn(const Instruction instruction) -> void {
+		if (semantics::skip_taken<Opcode::SKIP_VX_EQ_NN>(m_cpu.registers, instruction)) {
+			skip();
+		}
+	}
+	auto Chip8::op_skip_vx_neq_nn(const Instruction instruction) -> void {
+		if (semantics::skip_taken<Opcode::SKIP_VX_NEQ_NN>(m_cpu.registers, instruction)) {
+			skip();
+		}
+	}
+	auto Chip8::op_skip_vx_eq_vy(const Instruction instruction) -> void {
+		if (semantics::skip_taken<Opcode::SKIP_VX_EQ_VY>(m_cpu.registers, instruction)) {
+			skip();
+		}
+	}
+	auto Chip8::op_vx_set(const Instruction instruction) -> void {
+		m_cpu.registers.set_register(instruction.vx, instruction.literal);
+	}
+	auto Chip8::op_vx_add(const Instruction instruction) -> void {
+		m_cpu.registers.set_register(
+			instruction.vx,
+			m_cpu.registers.get_register(instruction.vx) + instruction.literal);
+	}
+	auto Chip8::op_set_vx_to_vy(const Instruction instruction) -> void {
+		m_cpu.registers.set_register(instruction.vx, m_cpu.registers.get_register(instruction.vy));
+	}
+	auto Chip8::op_or_vx_with_vy(const Instruction instruction) -> void {
+		m_cpu.registers.set_register(instruction.vx,
+			m_cpu.registers.get_register(instruction.vx) | m_cpu.registers.get_register(instruction.vy));
+	}
+	auto Chip8::op_and_vx_with_vy(const Instruction instruction) -> void {
+		m_cpu.registers.set_register(instruction.vx,
+			m_cpu.registers.get_register(instruction.vx) & m_cpu.registers.get_register(instruction.vy));
+	}
+	auto Chip8::op_xor_vx_with_vy(const Instruction instruction) -> void {
+		m_cpu.registers.set_register(instruction.vx,
+			m_cpu.registers.get_register(instruction.vx) ^ m_cpu.registers.get_register(instruction.vy));
+	}
+	auto Chip8::op_add_vy_to_vx(const Instruction instruction) -> void {
+		semantics::add_vy_to_vx(m_cpu.registers, instruction.vx, instruction.vy);
+	}
+	auto Chip8::op_sub_vy_from_vx(const Instruction instruction) -> void {
+		semantics::sub_vy_from_vx(m_cpu.registers, instruction.vx, instruction.vy);
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::op_sr_vx_by_vy(const Instruction instruction) -> void {
+		semantics::shift_right<Q.putVYintoVXbeforeShift>(m_cpu.registers, instruction.vx, instruction.vy);
+	}
+	auto Chip8::op_sub_vx_from_vy(const Instruction instruction) -> void {
+		semantics::sub_vx_from_vy(m_cpu.registers, instruction.vx, instruction.vy);
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::op_sl_vx_by_vy(const Instruction instruction) -> void {
+		semantics::shift_left<Q.putVYintoVXbeforeShift>(m_cpu.registers, instruction.vx, instruction.vy);
+	}
+	auto Chip8::op_skip_vx_neq_vy(const Instruction instruction) -> void {
+		if (semantics::skip_taken<Opcode::SKIP_VX_NEQ_VY>(m_cpu.registers, instruction)) {
+			skip();
+		}
+	}
+	auto Chip8::op_set_i(const Instruction instruction) -> void {
+		m_cpu.registers.I = instruction.address;
+		m_cpu.registers.bank = 0;
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::op_jr(const Instruction instruction) -> void {
+		if constexpr (Q.useVXinsteadOfV0) {
+			m_cpu.registers.PC = instruction.address + m_cpu.registers.V[instruction.vx];
+		}
+		else {
+			m_cpu.registers.PC = instruction.address + m_cpu.registers.V[0];
+		}
+	}
+	auto Chip8::op_random(const Instruction instruction) -> void {
+		m_cpu.registers.set_register(instruction.vx, semantics::next_random(m_random) & instruction.literal);
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::op_draw(const Instruction instruction) -> void {
+		m_draws++;
+		if (m_megaChip) {
+			draw_mega(instruction);
+			return;
+		}
+
+		const int x = m_cpu.registers.get_register(instruction.vx) & (get_display_width() - 1);
+		const int y = m_cpu.registers.get_register(instruction.vy) & (get_display_height() - 1);
+		// DXY0 draws a 16x16 sprite stored as two bytes per row, or nothing in plain CHIP-8 low resolution.
+		const bool large = (instruction.literal & 0xF) == 0 && (Q.largeSprites || m_highResolution);
+		const int rows = large ? 16 : instruction.literal & 0xF;
+		const int size = large ? 32 : rows;
+
+		// Every selected plane takes the next sprite from memory, collisions on any of them count.
+		static_assert(RAM_GUARD >= 32, "a 16x16 sprite has to fit in the guard");
+		uint64_t collision = 0;
+		uint32_t address = memory_address(0);
+		for (uint8_t planes = m_planes; planes; planes &= planes - 1) {
+			collision |= semantics::draw_sprite<Q.clipping>(m_displayMemory[std::countr_zero(planes)], read_burst(address), x, y, rows, large, m_highResolution);
+			address = (address + size) & m_ramMask;
+		}
+		m_cpu.registers.V[0xF] = collision != 0;
+	}
+	auto Chip8::op_key_pressed(const Instruction instruction) -> void {
+		const uint8_t vxValue = m_cpu.registers.get_register(instruction.vx) & 0xF;
+		if (m_cpu.keys >> vxValue & 1) skip();
+	}
+	auto Chip8::op_key_not_pressed(const Instruction instruction) -> void {
+		const uint8_t vxValue = m_cpu.registers.get_register(instruction.vx) & 0xF;
+		if (!(m_cpu.keys >> vxValue & 1)) skip();
+	}
+	auto Chip8::op_set_vx_to_delay(const Instruction instruction) -> void {
+		m_cpu.registers.set_register(instruction.vx, m_cpu.registers.delay);
+
+		// Stepping through a delay wait counts it like the fused handler and skip_idle do.
+		const uint16_t address = (m_cpu.registers.PC - 2) & (CODE_SIZE - 1);
+		if (m_decoded[address].fusion == Fusion::DELAY_WAIT) {
+			m_delayWaitInstructions += semantics::delay_wait_round(m_cpu.registers.delay, m_decoded[(address + 2) & (CODE_SIZE - 1)]);
+		}
+	}
+	auto Chip8::op_wait_for_keypress(const Instruction instruction) -> void {
+		const int key = semantics::wait_for_keypress(m_cpu.key, m_cpu.keys);
+		if (key >= 0) {
+			m_cpu.registers.set_register(instruction.vx, static_cast<uint8_t>(key));
+			return;
+		}
+		m_cpu.registers.PC -= 2;
+	}
+	auto Chip8::op_set_delay_to_vx(const Instruction instruction) -> void {
+		m_cpu.registers.delay = m_cpu.registers.get_register(instruction.vx);
+	}
+	auto Chip8::op_set_sound_to_vx(const Instruction instruction) -> void {
+		m_cpu.registers.sound = m_cpu.registers.get_register(instruction.vx);
+	}
+	auto Chip8::op_add_vx_to_i(const Instruction instruction) -> void {
+		if (m_megaChip) {
+			const uint32_t sum = (m_cpu.registers.bank << 16 | m_cpu.registers.I) + m_cpu.registers.get_register(instruction.vx);
+			m_cpu.registers.bank = static_cast<uint8_t>(sum >> 16);
+		}
+		semantics::add_vx_to_i(m_cpu.registers, instruction.vx);
+	}
+	auto Chip8::op_set_i_to_hex_character(const Instruction instruction) -> void {
+		semantics::set_i_to_hex_character(m_cpu.registers, instruction.vx);
+	}
+	auto Chip8::op_bcd_vx(const Instruction instruction) -> void {
+		const std::array<uint8_t, 3> digits = semantics::bcd(m_cpu.registers.get_register(instruction.vx));
+		for (int i = 0; i < 3; i++) {
+			write_memory(memory_address(i), digits[i]);
+		}
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::op_save_vx(const Instruction instruction) -> void {
+		semantics::save_registers<Q.changeValueOfI>(m_cpu.registers, instruction.vx, [&](const int offset, const uint8_t value) {
+			write_memory(memory_address(offset), value);
+			});
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::op_load_vx(const Instruction instruction) -> void {
+		semantics::load_registers<Q.changeValueOfI>(m_cpu.registers, instruction.vx, read_burst(memory_address(0)));
+	}
+
+	auto Chip8::op_scroll_down(const Instruction instruction) -> void {
+		if (m_megaChip) {
+			scroll_mega(0, instruction.literal & 0xF);
+			return;
+		}
+
+		const int height = get_display_height();
+		const int lines = std::min(instruction.literal & 0xF, height);
+		for (int plane = 0; plane < PLANES; plane++) {
+			if (!(m_planes >> plane & 1)) continue;
+			DisplayMemory& display = m_displayMemory[plane];
+			std::move_backward(display.begin(), display.begin() + height - lines, display.begin() + height);
+			std::fill(display.begin(), display.begin() + lines, DisplayRow{});
+		}
+	}
+	auto Chip8::op_scroll_right(const Instruction instruction) -> void {
+		if (m_megaChip) {
+			scroll_mega(4, 0);
+			return;
+		}
+
+		for (int plane = 0; plane < PLANES; plane++) {
+			if (!(m_planes >> plane & 1)) continue;
+			for (int y = 0; y < get_display_height(); y++) {
+				DisplayRow& row = m_displayMemory[plane][y];
+				if (m_highResolution) {
+					row[1] = row[1] >> 4 | row[0] << 60;
+				}
+				row[0] >>= 4;
+			}
+		}
+	}
+	auto Chip8::op_scroll_left(const Instruction instruction) -> void {
+		if (m_megaChip) {
+			scroll_mega(-4, 0);
+			return;
+		}
+
+		for (int plane = 0; plane < PLANES; plane++) {
+			if (!(m_planes >> plane & 1)) continue;
+			for (int y = 0; y < get_display_height(); y++) {
+				DisplayRow& row = m_displayMemory[plane][y];
+				row[0] <<= 4;
+				if (m_highResolution) {
+					row[0] |= row[1] >> 60;
+					row[1] <<= 4;
+				}
+			}
+		}
+	}
+	auto Chip8::op_exit(const Instruction instruction) -> void {
+		m_cpu.halted = 1;
+		m_cpu.registers.PC -= 2;
+	}
+	auto Chip8::op_low_res(const Instruction instruction) -> void {
+		m_highResolution = 0;
+		m_displayMemory = {};
+	}
+	auto Chip8::op_high_res(const Instruction instruction) -> void {
+		m_highResolution = 1;
+		m_displayMemory = {};
+	}
+	auto Chip8::op_set_i_to_big_character(const Instruction instruction) -> void {
+		m_cpu.registers.I = BIG_FONT_ADDRESS + (m_cpu.registers.get_register(instruction.vx) & 0xF) * 10;
+		m_cpu.registers.bank = 0;
+	}
+	auto Chip8::op_save_flags(const Instruction instruction) -> void {
+		for (int i = 0; i <= instruction.vx; i++) {
+			m_flags[i] = m_cpu.registers.V[i];
+		}
+	}
+	auto Chip8::op_load_flags(const Instruction instruction) -> void {
+		for (int i = 0; i <= instruction.vx; i++) {
+			m_cpu.registers.V[i] = m_flags[i];
+		}
+	}
+	auto Chip8::op_set_i_long(const Instruction instruction) -> void {
+		// The operand is read when the instruction runs, programs commonly rewrite it.
+		const uint16_t operand = m_cpu.registers.PC & (CODE_SIZE - 1);
+		m_cpu.registers.I = m_RAM[operand] << 8 | m_RAM[(operand + 1) & (CODE_SIZE - 1)];
+		m_cpu.registers.bank = 0;
+		m_cpu.registers.PC = (operand + 2) & 0xFFF;
+	}
+	auto Chip8::op_select_planes(const Instruction instruction) -> void {
+		m_planes = instruction.vx;
+	}
+	auto Chip8::op_save_vx_to_vy(const Instruction instruction) -> void {
+		// Either order is allowed, the registers land in memory in the order they are named.
+		const int step = instruction.vx <= instruction.vy ? 1 : -1;
+		for (int i = 0, v = instruction.vx; ; i++, v += step) {
+			write_memory(memory_address(i), m_cpu.registers.V[v]);
+			if (v == instruction.vy) break;
+		}
+	}
+	auto Chip8::op_load_vx_to_vy(const Instruction instruction) -> void {
+		const int step = instruction.vx <= instruction.vy ? 1 : -1;
+		const uint8_t* source = read_burst(memory_address(0));
+		for (int i = 0, v = instruction.vx; ; i++, v += step) {
+			m_cpu.registers.V[v] = source[i];
+			if (v == instruction.vy) break;
+		}
+	}
+	auto Chip8::op_load_audio_pattern(const Instruction instruction) -> void {
+		std::memcpy(m_audioPattern.data(), read_burst(memory_address(0)), m_audioPattern.size());
+		m_hasAudioPattern = 1;
+	}
+	auto Chip8::op_set_pitch_to_vx(const Instruction instruction) -> void {
+		m_pitch = m_cpu.registers.get_register(instruction.vx);
+	}
+	auto Chip8::op_scroll_up(const Instruction instruction) -> void {
+		if (m_megaChip) {
+			scroll_mega(0, -(instruction.literal & 0xF));
+			return;
+		}
+
+		const int height = get_display_height();
+		const int lines = std::min(instruction.literal & 0xF, height);
+		for (int plane = 0; plane < PLANES; plane++) {
+			if (!(m_planes >> plane & 1)) continue;
+			DisplayMemory& display = m_displayMemory[plane];
+			std::move(display.begin() + lines, display.begin() + height, display.begin());
+			std::fill(display.begin() + height - lines, display.begin() + height, DisplayRow{});
+		}
+	}
+
+	auto Chip8::op_mega_off(const Instruction instruction) -> void {
+		m_megaChip = 0;
+		m_cpu.registers.bank = 0;
+		m_displayMemory = {};
+	}
+	auto Chip8::op_mega_on(const Instruction instruction) -> void {
+		m_megaChip = 1;
+		m_megaIndices.assign(MEGA_DISPLAY_X * MEGA_DISPLAY_Y, 0);
+		m_megaPixels.assign(MEGA_DISPLAY_X * MEGA_DISPLAY_Y, 0);
+		m_megaFrame.assign(MEGA_DISPLAY_X * MEGA_DISPLAY_Y, 0);
+		m_megaFrameCount++;
+	}
+	auto Chip8::op_set_i_mega(const Instruction instruction) -> void {
+		// Outside MEGA-CHIP mode this is a machine code call like any other 0NNN.
+		if (!m_megaChip) return;
+
+		const uint16_t operand = m_cpu.registers.PC & (CODE_SIZE - 1);
+		m_cpu.registers.bank = instruction.literal;
+		m_cpu.registers.I = m_RAM[operand] << 8 | m_RAM[(operand + 1) & (CODE_SIZE - 1)];
+		m_cpu.registers.PC = (operand + 2) & 0xFFF;
+	}
+	auto Chip8::op_load_palette(const Instruction instruction) -> void {
+		// Colors are stored as ARGB and fill the palette from index 1, index 0 is always transparent.
+		for (int i = 0; i < instruction.literal && i < 255; i++) {
+			uint32_t color = 0;
+			for (int byte = 0; byte < 4; byte++) {
+				color = color << 8 | m_RAM[memory_address(i * 4 + byte)];
+			}
+			m_palette[i + 1] = color;
+		}
+	}
+	auto Chip8::op_set_sprite_width(const Instruction instruction) -> void {
+		m_spriteWidth = instruction.literal ? instruction.literal : 256;
+	}
+	auto Chip8::op_set_sprite_height(const Instruction instruction) -> void {
+		m_spriteHeight = instruction.literal ? instruction.literal : 256;
+	}
+	auto Chip8::op_set_screen_alpha(const Instruction instruction) -> void {
+		m_screenAlpha = instruction.literal;
+	}
+	auto Chip8::op_play_sample(const Instruction instruction) -> void {
+		if (!m_megaChip) return;
+
+		// The header holds a 16 bit sample rate and a 24 bit length, the samples follow a reserved byte.
+		const uint8_t* header = read_burst(memory_address(0));
+		const int rate = header[0] << 8 | header[1];
+		const uint32_t length = header[2] << 16 | header[3] << 8 | header[4];
+		const uint32_t start = memory_address(6);
+		const size_t available = m_ramMask + 1 - start;
+
+		m_sample = {
+			.data = std::span<const uint8_t>(m_RAM.data() + start, std::min<size_t>(length, available)),
+			.rate = rate,
+			.loop = (instruction.literal & 0xF) == 0,
+			.serial = m_sample.serial + 1,
+		};
+	}
+	auto Chip8::op_stop_sample(const Instruction instruction) -> void {
+		m_sample.data = {};
+	}
+	auto Chip8::op_set_blend_mode(const Instruction instruction) -> void {
+		m_blendMode = static_cast<BlendMode>(std::min(instruction.literal & 0xF, static_cast<int>(BlendMode::MULTIPLY)));
+	}
+	auto Chip8::op_set_collision_color(const Instruction instruction) -> void {
+		m_collisionColor = instruction.literal;
+	}
+
+	auto Chip8::draw_mega(const Instruction instruction) -> void {
+		const int x = m_cpu.registers.get_register(instruction.vx);
+		const int y = m_cpu.registers.get_register(instruction.vy);
+		const uint32_t address = memory_address(0);
+
+		// Only pixels landing on the collision color count, an empty pixel never does.
+		bool collision = 0;
+		auto plot = [&](const int px, const int py, const uint8_t color) -> void {
+			const int pixel = py * MEGA_DISPLAY_X + px;
+			const uint8_t previous = m_megaIndices[pixel];
+			collision |= previous != 0 && previous == m_collisionColor;
+			m_megaIndices[pixel] = color;
+			m_megaPixels[pixel] = blend(m_palette[color], m_megaPixels[pixel]);
+		};
+
+		// The built-in fonts are still one bit sprites, drawn in the last palette entry.
+		if (address < 0x200) {
+			const int rows = instruction.literal & 0xF;
+			for (int j = 0; j < rows && y + j < MEGA_DISPLAY_Y; j++) {
+				const uint8_t bits = m_RAM[address + j];
+				for (int i = 0; i < 8 && x + i < MEGA_DISPLAY_X; i++) {
+					if (bits >> (7 - i) & 1) plot(x + i, y + j, 0xFF);
+				}
+			}
+			m_cpu.registers.V[0xF] = collision;
+			return;
+		}
+
+		// One byte per pixel, palette index 0 is transparent. Sprites are clipped at the edges.
+		const int width = std::min(m_spriteWidth, MEGA_DISPLAY_X - x);
+		const int height = std::min(m_spriteHeight, MEGA_DISPLAY_Y - y);
+		for (int j = 0; j < height; j++) {
+			const uint32_t row = address + j * m_spriteWidth;
+			for (int i = 0; i < width; i++) {
+				const uint8_t color = m_RAM[(row + i) & m_ramMask];
+				if (color) plot(x + i, y + j, color);
+			}
+		}
+		m_cpu.registers.V[0xF] = collision;
+	}
+	auto Chip8::blend(const uint32_t source, const uint32_t target) const -> uint32_t {
+		const uint32_t alpha = source >> 24;
+		if (m_blendMode == BlendMode::NORMAL && alpha == 0xFF) {
+			return source;
+		}
+
+		uint32_t result = 0xFF000000;
+		for (int shift = 0; shift < 24; shift += 8) {
+			const uint32_t from = source >> shift & 0xFF;
+			const uint32_t to = target >> shift & 0xFF;
+			const uint32_t channel = [&]() -> uint32_t {
+				switch (m_blendMode) {
+				case BlendMode::ADD: return std::min<uint32_t>(from + to, 0xFF);
+				case BlendMode::MULTIPLY: return from * to / 0xFF;
+				default: {
+					const uint32_t weight = m_blendMode == BlendMode::QUARTER ? alpha / 4 : m_blendMode == BlendMode::HALF ? alpha / 2 : alpha;
+					return (from * weight + to * (0xFF - weight)) / 0xFF;
+				}
+				}
+				}();
+			result |= channel << shift;
+		}
+		return result;
+	}
+	auto Chip8::scroll_mega(const int dx, const int dy) -> void {
+		auto scroll = [&]<typename T>(std::vector<T>& buffer) -> void {
+			const auto begin = buffer.begin();
+			const auto end = buffer.end();
+			const int rows = std::min(std::abs(dy), MEGA_DISPLAY_Y) * MEGA_DISPLAY_X;
+			if (dy > 0) {
+				std::move_backward(begin, end - rows, end);
+				std::fill(begin, begin + rows, T{});
+			}
+			else if (dy < 0) {
+				std::move(begin + rows, end, begin);
+				std::fill(end - rows, end, T{});
+			}
+
+			const int columns = std::abs(dx);
+			for (int y = 0; y < MEGA_DISPLAY_Y && dx != 0; y++) {
+				const auto row = begin + y * MEGA_DISPLAY_X;
+				if (dx > 0) {
+					std::move_backward(row, row + MEGA_DISPLAY_X - columns, row + MEGA_DISPLAY_X);
+					std::fill(row, row + columns, T{});
+				}
+				else {
+					std::move(row + columns, row + MEGA_DISPLAY_X, row);
+					std::fill(row + MEGA_DISPLAY_X - columns, row + MEGA_DISPLAY_X, T{});
+				}
+			}
+		};
+		scroll(m_megaIndices);
+		scroll(m_megaPixels);
+	}
+
+	// Fused handlers return the number of instructions they executed. Only the first instruction of a
+	// sequence may read the timers, because they are advanced after the whole sequence.
+	auto Chip8::fused_delay_wait(const uint16_t address) -> int {
+		const Instruction& skip = m_decoded[(address + 2) & (CODE_SIZE - 1)];
+
+		m_cpu.registers.set_register(skip.vx, m_cpu.registers.delay);
+		const int executed = semantics::delay_wait_round(m_cpu.registers.delay, skip);
+		m_delayWaitInstructions += executed;
+		m_cpu.registers.PC = executed == 2 ? ((address + 4) & 0xFFF) + 2 : address;
+		return executed;
+	}
+	auto Chip8::fused_load_pair(const uint16_t address) -> int {
+		const Instruction& first = m_decoded[address];
+		const Instruction& second = m_decoded[(address + 2) & (CODE_SIZE - 1)];
+
+		m_cpu.registers.set_register(first.vx, first.literal);
+		m_cpu.registers.set_register(second.vx, second.literal);
+		m_cpu.registers.PC = (address + 4) & 0xFFF;
+		return 2;
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::fused_set_i_and_draw(const uint16_t address) -> int {
+		const Instruction& draw = m_decoded[(address + 2) & (CODE_SIZE - 1)];
+
+		m_cpu.registers.I = m_decoded[address].address;
+		m_cpu.registers.bank = 0;
+		m_cpu.registers.PC = (address + 4) & 0xFFF;
+		op_draw<Q>(draw);
+		return 2;
+	}
+	template<Chip8::Quirks Q>
+	auto Chip8::fused_skip_jump(const uint16_t address) -> int {
+		const uint16_t next = (address + 2) & 0xFFF;
+
+		m_cpu.registers.PC = next;
+		execute_threaded<Q>(m_decoded[address]);
+		if (m_cpu.registers.PC != next) {
+			return 1;
+		}
+
+		m_cpu.registers.PC = m_decoded[next].address;
+		return 2;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "Chip8/Governor.hpp"
+
+#include <algorithm>
+
+namespace ks {
+	namespace {
+		// Share of instructions spent waiting for the delay timer. Above the first the ROM has time to
+		// spare, below the second it has none left.
+		constexpr double WAITING_A_LOT = 0.5;
+		constexpr double HARDLY_WAITING = 0.1;
+		// A ROM that does not wait only looks slow if it draws.
+		constexpr double DRAWS_PER_FRAME = 1.0;
+		// The rate moves by an eighth at a time, so it settles instead of swinging between the bounds.
+		constexpr int STEP_DIVISOR = 8;
+	}
+
+	auto Governor::update(Chip8& chip8) -> void {
+		const uint64_t executed = chip8.get_executed_instructions();
+		const uint64_t delayWait = chip8.get_delay_wait_instructions();
+		const uint64_t draws = chip8.get_draw_count();
+		if (!m_started) {
+			m_started = 1;
+			m_executed = executed;
+			m_delayWait = delayWait;
+			m_draws = draws;
+			return;
+		}
+
+		const int perFrame = std::max(chip8.get_instructions_per_second() / Chip8::TIMER_FREQUENCY, 1);
+		const uint64_t observed = executed - m_executed;
+		if (observed < static_cast<uint64_t>(perFrame) * EVALUATION_FRAMES) return;
+
+		const double frames = static_cast<double>(observed) * Chip8::TIMER_FREQUENCY / chip8.get_instructions_per_second();
+		const double waiting = static_cast<double>(delayWait - m_delayWait) / observed;
+		const double drawsPerFrame = (draws - m_draws) / frames;
+
+		const double drawsPerInstruction = static_cast<double>(draws - m_draws) / observed;
+
+		int target = perFrame;
+		const int step = std::max(perFrame / STEP_DIVISOR, 1);
+		if (waiting > WAITING_A_LOT) {
+			target -= step;
+			m_raisedFrom = {};
+		}
+		else if (waiting < HARDLY_WAITING && drawsPerFrame >= DRAWS_PER_FRAME && paid_off(perFrame, drawsPerInstruction)) {
+			target += step;
+			m_raisedFrom = { perFrame, drawsPerInstruction };
+		}
+		target = std::clamp(target, m_bounds.minimum, m_bounds.maximum);
+		if (target != perFrame) {
+			chip8.set_instructions_per_second(target * Chip8::TIMER_FREQUENCY);
+		}
+
+		m_executed = executed;
+		m_delayWait = delayWait;
+		m_draws = draws;
+	}
+	auto Governor::reset() -> void {
+		m_started = 0;
+		m_raisedFrom = {};
+	}
+	// A ROM limited by the CPU draws in proportion to the instructions it gets, so its draws per
+	// instruction hold when the rate goes up. One that paces itself in a loop the idle skip does not
+	// recognize spreads the same draws over more instructions. The raise paid off if the share held
+	// at least halfway between the two.
+	auto Governor::paid_off(const int perFrame, const double drawsPerInstruction) const -> bool {
+		if (m_raisedFrom.perFrame == 0 || m_raisedFrom.perFrame >= perFrame) return 1;
+
+		const double paced = m_raisedFrom.drawsPerInstruction * m_raisedFrom.perFrame / perFrame;
+		return drawsPerInstruction * 2 >= m_raisedFrom.drawsPerInstruction + paced;
+	}
+}
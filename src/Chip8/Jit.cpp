@@ -0,0 +1,353 @@
+#include "Chip8/Jit.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define KS_JIT_X64 1
+#else
+#define KS_JIT_X64 0
+#endif
+
+namespace ks {
+	static constexpr size_t CODE_CAPACITY = 512 * 1024;
+	// Upper bound of bytes emitted for one block, checked before translating into the code region.
+	static constexpr size_t MAX_BLOCK_BYTES = 64 + Jit::MAX_BLOCK_LENGTH * 40;
+
+	static auto allocate_executable(const size_t size) -> uint8_t* {
+#if !KS_JIT_X64
+		return nullptr;
+#elif defined(_WIN32)
+		return static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
+#else
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		return memory == MAP_FAILED ? nullptr : static_cast<uint8_t*>(memory);
+#endif
+	}
+	static auto free_executable(uint8_t* memory, const size_t size) -> void {
+		if (!memory) return;
+#if defined(_WIN32)
+		VirtualFree(memory, 0, MEM_RELEASE);
+#else
+		munmap(memory, size);
+#endif
+	}
+
+	// Instructions that leave the block after they are executed.
+	static auto is_terminator(const Opcode op) -> bool {
+		switch (op) {
+			using enum Opcode;
+		case RET:
+		case JP:
+		case CALL:
+		case SKIP_VX_EQ_NN:
+		case SKIP_VX_NEQ_NN:
+		case SKIP_VX_EQ_VY:
+		case SKIP_VX_NEQ_VY:
+		case JR:
+		case KEY_PRESSED:
+		case KEY_NOT_PRESSED:
+		case WAIT_FOR_KEYPRESS:
+		case BCD_VX:
+		case SAVE_VX:
+		case EXIT:
+		case SET_I_LONG:
+		case SAVE_VX_TO_VY:
+		// MEGA-CHIP switches engines, and 01NN NNNN reads its operand at PC.
+		case MEGA_OFF:
+		case MEGA_ON:
+		case SET_I_MEGA:
+			return 1;
+		default:
+			return 0;
+		}
+	}
+	static auto uses_timers(const Opcode op) -> bool {
+		return op == Opcode::SET_VX_TO_DELAY || op == Opcode::SET_DELAY_TO_VX || op == Opcode::SET_SOUND_TO_VX;
+	}
+
+	Jit::Jit(const Layout layout)
+		: m_layout(layout)
+	{
+		m_code = allocate_executable(CODE_CAPACITY);
+		m_capacity = m_code ? CODE_CAPACITY : 0;
+		m_buffer.reserve(MAX_BLOCK_BYTES);
+	}
+	Jit::~Jit() {
+		free_executable(m_code, m_capacity);
+	}
+
+	auto Jit::is_supported() -> bool {
+		return KS_JIT_X64;
+	}
+
+	auto Jit::translate(
+		const uint16_t address,
+		const std::span<const uint8_t, ADDRESS_SPACE> ram,
+		const std::span<const Instruction, ADDRESS_SPACE> decoded,
+		const Fallback fallback,
+		const bool shiftUsesVY
+	) -> const Block& {
+		m_fallback = fallback;
+		Block& block = m_blocks[address];
+		block = { .translated = 1 };
+		m_covered[address] = 1;
+		if (!m_code) return block;
+
+		// Running out of space drops every block. This only happens between blocks, never inside one.
+		if (m_used + MAX_BLOCK_BYTES > m_capacity) {
+			flush();
+			m_blocks[address] = { .translated = 1 };
+			m_covered[address] = 1;
+		}
+
+		m_buffer.clear();
+		emit_prologue();
+
+		auto V = [&](const uint8_t index) -> uint8_t {
+			return m_layout.V + index;
+		};
+
+		uint16_t pc = address;
+		int length = 0;
+		bool terminated = 0;
+		while (length < MAX_BLOCK_LENGTH && !terminated) {
+			const Instruction instruction = decoded[pc];
+			// Delay waits are left to the interpreter, which counts the time spent in them.
+			if (length > 0 && instruction.fusion == Fusion::DELAY_WAIT) break;
+			if (uses_timers(instruction.op)) {
+				block.timerIndex = static_cast<int8_t>(length);
+			}
+			if (instruction.op == Opcode::DRAW && block.drawIndex < 0) {
+				block.drawIndex = static_cast<int8_t>(length);
+			}
+
+			const uint16_t opcode = ram[pc] << 8 | ram[(pc + 1) & (ADDRESS_SPACE - 1)];
+			const uint16_t next = (pc + 2) & (ADDRESS_SPACE - 1);
+			const uint8_t vx = V(instruction.vx);
+			const uint8_t vy = V(instruction.vy);
+
+			if (is_terminator(instruction.op)) {
+				terminated = 1;
+			}
+
+			switch (instruction.op) {
+				using enum Opcode;
+			case NOP:
+				break;
+			case JP:
+				emit_set_pc(instruction.address);
+				break;
+			case SKIP_VX_EQ_NN:
+			case SKIP_VX_NEQ_NN:
+			case SKIP_VX_EQ_VY:
+			case SKIP_VX_NEQ_VY: {
+				// A skipped F000 NNNN is four bytes long.
+				const uint16_t skipped = (next + (decoded[next].op == SET_I_LONG ? 4 : 2)) & (ADDRESS_SPACE - 1);
+				emit_set_pc(next);
+				if (instruction.op == SKIP_VX_EQ_NN || instruction.op == SKIP_VX_NEQ_NN) {
+					emit({ 0x80, 0x7B, vx, instruction.literal });	// cmp byte [rbx + vx], nn
+				}
+				else {
+					emit({ 0x8A, 0x43, vx });						// mov al, [rbx + vx]
+					emit({ 0x3A, 0x43, vy });						// cmp al, [rbx + vy]
+				}
+				const bool skipIfEqual = instruction.op == SKIP_VX_EQ_NN || instruction.op == SKIP_VX_EQ_VY;
+				emit({ static_cast<uint8_t>(skipIfEqual ? 0x75 : 0x74), 0x06 });	// jne/je over the store below
+				emit_set_pc(skipped);
+			}	break;
+			case VX_SET:
+				emit({ 0xC6, 0x43, vx, instruction.literal });		// mov byte [rbx + vx], nn
+				break;
+			case VX_ADD:
+				emit({ 0x80, 0x43, vx, instruction.literal });		// add byte [rbx + vx], nn
+				break;
+			case SET_VX_TO_VY:
+				emit({ 0x8A, 0x43, vy });							// mov al, [rbx + vy]
+				emit({ 0x88, 0x43, vx });							// mov [rbx + vx], al
+				break;
+			case OR_VX_WITH_VY:
+			case AND_VX_WITH_VY:
+			case XOR_VX_WITH_VY: {
+				const uint8_t operation = instruction.op == OR_VX_WITH_VY ? 0x0A : instruction.op == AND_VX_WITH_VY ? 0x22 : 0x32;
+				emit({ 0x8A, 0x43, vx });							// mov al, [rbx + vx]
+				emit({ operation, 0x43, vy });						// or/and/xor al, [rbx + vy]
+				emit({ 0x88, 0x43, vx });							// mov [rbx + vx], al
+			}	break;
+			case ADD_VY_TO_VX:
+				emit({ 0x8A, 0x43, vx });							// mov al, [rbx + vx]
+				emit({ 0x02, 0x43, vy });							// add al, [rbx + vy]
+				emit({ 0x0F, 0x92, 0xC1 });							// setc cl
+				emit({ 0x88, 0x43, vx });							// mov [rbx + vx], al
+				emit({ 0x88, 0x4B, V(0xF) });						// mov [rbx + vf], cl
+				break;
+			case SUB_VY_FROM_VX:
+			case SUB_VX_FROM_VY: {
+				const bool reversed = instruction.op == SUB_VX_FROM_VY;
+				emit({ 0x8A, 0x43, reversed ? vy : vx });			// mov al, [rbx + minuend]
+				emit({ 0x2A, 0x43, reversed ? vx : vy });			// sub al, [rbx + subtrahend]
+				emit({ 0x0F, 0x93, 0xC1 });							// setnc cl
+				emit({ 0x88, 0x43, vx });							// mov [rbx + vx], al
+				emit({ 0x88, 0x4B, V(0xF) });						// mov [rbx + vf], cl
+			}	break;
+			case SR_VX_BY_VY:
+				emit({ 0x8A, 0x43, shiftUsesVY ? vy : vx });		// mov al, [rbx + source]
+				emit({ 0x88, 0xC1 });								// mov cl, al
+				emit({ 0x80, 0xE1, 0x01 });							// and cl, 1
+				emit({ 0xD0, 0xE8 });								// shr al, 1
+				emit({ 0x88, 0x43, vx });							// mov [rbx + vx], al
+				emit({ 0x88, 0x4B, V(0xF) });						// mov [rbx + vf], cl
+				break;
+			case SL_VX_BY_VY:
+				emit({ 0x8A, 0x43, shiftUsesVY ? vy : vx });		// mov al, [rbx + source]
+				emit({ 0x88, 0xC1 });								// mov cl, al
+				emit({ 0xC0, 0xE9, 0x07 });							// shr cl, 7
+				emit({ 0x00, 0xC0 });								// add al, al
+				emit({ 0x88, 0x43, vx });							// mov [rbx + vx], al
+				emit({ 0x88, 0x4B, V(0xF) });						// mov [rbx + vf], cl
+				break;
+			case SET_I:
+				emit({ 0x66, 0xC7, 0x43, m_layout.I });				// mov word [rbx + I], nnn
+				emit16(instruction.address);
+				break;
+			case ADD_VX_TO_I:
+				emit({ 0x0F, 0xB6, 0x43, vx });						// movzx eax, byte [rbx + vx]
+				emit({ 0x66, 0x03, 0x43, m_layout.I });				// add ax, [rbx + I]
+				emit({ 0x66, 0x81, 0x7B, m_layout.I });				// cmp word [rbx + I], 0xFFF
+				emit16(0xFFF);
+				emit({ 0x66, 0x89, 0x43, m_layout.I });				// mov [rbx + I], ax
+				emit({ 0x77, 0x0A });								// ja over the check below
+				emit({ 0x66, 0x3D });								// cmp ax, 0xFFF
+				emit16(0xFFF);
+				emit({ 0x76, 0x04 });								// jbe over the store below
+				emit({ 0xC6, 0x43, V(0xF), 0x01 });					// mov byte [rbx + vf], 1
+				break;
+			case SET_VX_TO_DELAY:
+				emit({ 0x8A, 0x43, m_layout.delay });				// mov al, [rbx + delay]
+				emit({ 0x88, 0x43, vx });							// mov [rbx + vx], al
+				break;
+			case SET_DELAY_TO_VX:
+			case SET_SOUND_TO_VX:
+				emit({ 0x8A, 0x43, vx });							// mov al, [rbx + vx]
+				emit({ 0x88, 0x43, instruction.op == SET_DELAY_TO_VX ? m_layout.delay : m_layout.sound });	// mov [rbx + timer], al
+				break;
+			case SET_I_TO_HEX_CHARACTER:
+				emit({ 0x0F, 0xB6, 0x43, vx });						// movzx eax, byte [rbx + vx]
+				emit({ 0x83, 0xE0, 0x0F });							// and eax, 0xF
+				emit({ 0x8D, 0x44, 0x80, 0x50 });					// lea eax, [rax + rax * 4 + 0x50]
+				emit({ 0x66, 0x89, 0x43, m_layout.I });				// mov [rbx + I], ax
+				break;
+			default:
+				// Control transfers resolved by the interpreter expect PC to point past the instruction.
+				if (terminated) emit_set_pc(next);
+				emit_fallback(opcode);
+				break;
+			}
+
+			length++;
+			pc = next;
+			if (pc == 0) break;
+		}
+
+		if (length == 0) {
+			return block;
+		}
+		if (!terminated) {
+			emit_set_pc(pc);
+		}
+		emit_epilogue();
+
+		uint8_t* code = m_code + m_used;
+		std::memcpy(code, m_buffer.data(), m_buffer.size());
+		m_used += m_buffer.size();
+
+		block.code = reinterpret_cast<Code>(code);
+		block.length = static_cast<uint8_t>(length);
+		for (int i = 0; i < length * 2; i++) {
+			m_covered[(address + i) & (ADDRESS_SPACE - 1)] = 1;
+		}
+		return block;
+	}
+
+	auto Jit::invalidate(const uint16_t address) -> void {
+		if (!m_covered[address]) return;
+
+		// Any block starting up to MAX_BLOCK_LENGTH instructions earlier may contain the byte.
+		for (int offset = 0; offset < MAX_BLOCK_LENGTH * 2; offset++) {
+			const uint16_t start = (address - offset) & (ADDRESS_SPACE - 1);
+			Block& block = m_blocks[start];
+			if (!block.translated) continue;
+			if (offset < std::max(block.length * 2, 2)) {
+				block = {};
+			}
+		}
+	}
+	auto Jit::flush() -> void {
+		m_blocks = {};
+		m_covered.reset();
+		m_used = 0;
+	}
+
+	auto Jit::emit(const std::initializer_list<uint8_t> bytes) -> void {
+		m_buffer.insert(m_buffer.end(), bytes);
+	}
+	auto Jit::emit16(const uint16_t value) -> void {
+		emit({ static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8) });
+	}
+	auto Jit::emit32(const uint32_t value) -> void {
+		emit16(static_cast<uint16_t>(value));
+		emit16(static_cast<uint16_t>(value >> 16));
+	}
+	auto Jit::emit64(const uint64_t value) -> void {
+		emit32(static_cast<uint32_t>(value));
+		emit32(static_cast<uint32_t>(value >> 32));
+	}
+
+	auto Jit::emit_prologue() -> void {
+		emit({ 0x53 });												// push rbx
+		emit({ 0x41, 0x54 });										// push r12
+#if defined(_WIN32)
+		emit({ 0x48, 0x83, 0xEC, 0x28 });							// sub rsp, 40 (shadow space)
+		emit({ 0x49, 0x89, 0xCC });									// mov r12, rcx
+		emit({ 0x48, 0x89, 0xD3 });									// mov rbx, rdx
+#else
+		emit({ 0x48, 0x83, 0xEC, 0x08 });							// sub rsp, 8
+		emit({ 0x49, 0x89, 0xFC });									// mov r12, rdi
+		emit({ 0x48, 0x89, 0xF3 });									// mov rbx, rsi
+#endif
+	}
+	auto Jit::emit_epilogue() -> void {
+#if defined(_WIN32)
+		emit({ 0x48, 0x83, 0xC4, 0x28 });							// add rsp, 40
+#else
+		emit({ 0x48, 0x83, 0xC4, 0x08 });							// add rsp, 8
+#endif
+		emit({ 0x41, 0x5C });										// pop r12
+		emit({ 0x5B });												// pop rbx
+		emit({ 0xC3 });												// ret
+	}
+	auto Jit::emit_set_pc(const uint16_t value) -> void {
+		emit({ 0x66, 0xC7, 0x43, m_layout.PC });					// mov word [rbx + PC], value
+		emit16(value);
+	}
+	auto Jit::emit_fallback(const uint16_t opcode) -> void {
+#if defined(_WIN32)
+		emit({ 0x4C, 0x89, 0xE1 });									// mov rcx, r12
+		emit({ 0xBA });												// mov edx, opcode
+#else
+		emit({ 0x4C, 0x89, 0xE7 });									// mov rdi, r12
+		emit({ 0xBE });												// mov esi, opcode
+#endif
+		emit32(opcode);
+		emit({ 0x48, 0xB8 });										// mov rax, fallback
+		emit64(reinterpret_cast<uint64_t>(m_fallback));
+		emit({ 0xFF, 0xD0 });										// call rax
+	}
+}
\ No newline at end of file
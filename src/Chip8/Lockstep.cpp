@@ -0,0 +1,593 @@
+#include "Chip8/Lockstep.hpp"
+#include "Chip8/Semantics.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <utility>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace ks {
+	namespace {
+		using Lockstep8 = Lockstep::Lanes<uint8_t>;
+		using Lockstep16 = Lockstep::Lanes<uint16_t>;
+
+#ifdef __AVX2__
+		// One 8 bit value per lane. Masks are 0xFF in selected lanes and 0 elsewhere.
+		struct Bytes {
+			__m256i v;
+		};
+		// One 16 bit value per lane, lanes 0-15 in lo and 16-31 in hi.
+		struct Words {
+			__m256i lo, hi;
+		};
+
+		auto load(const Lockstep8& lanes) -> Bytes {
+			return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.data())) };
+		}
+		auto store(Lockstep8& lanes, const Bytes a) -> void {
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.data()), a.v);
+		}
+		auto bytes(const uint8_t value) -> Bytes {
+			return { _mm256_set1_epi8(static_cast<char>(value)) };
+		}
+		auto operator +(const Bytes a, const Bytes b) -> Bytes {
+			return { _mm256_add_epi8(a.v, b.v) };
+		}
+		auto operator -(const Bytes a, const Bytes b) -> Bytes {
+			return { _mm256_sub_epi8(a.v, b.v) };
+		}
+		auto operator &(const Bytes a, const Bytes b) -> Bytes {
+			return { _mm256_and_si256(a.v, b.v) };
+		}
+		auto operator |(const Bytes a, const Bytes b) -> Bytes {
+			return { _mm256_or_si256(a.v, b.v) };
+		}
+		auto operator ^(const Bytes a, const Bytes b) -> Bytes {
+			return { _mm256_xor_si256(a.v, b.v) };
+		}
+		auto equal(const Bytes a, const Bytes b) -> Bytes {
+			return { _mm256_cmpeq_epi8(a.v, b.v) };
+		}
+		auto at_least(const Bytes a, const Bytes b) -> Bytes {
+			return { _mm256_cmpeq_epi8(_mm256_max_epu8(a.v, b.v), a.v) };
+		}
+		auto shift_right(const Bytes a) -> Bytes {
+			return { _mm256_and_si256(_mm256_srli_epi16(a.v, 1), _mm256_set1_epi8(0x7F)) };
+		}
+		auto saturating_sub(const Bytes a, const Bytes b) -> Bytes {
+			return { _mm256_subs_epu8(a.v, b.v) };
+		}
+		auto select(const Bytes mask, const Bytes a, const Bytes b) -> Bytes {
+			return { _mm256_blendv_epi8(b.v, a.v, mask.v) };
+		}
+		auto bits(const Bytes mask) -> uint32_t {
+			return static_cast<uint32_t>(_mm256_movemask_epi8(mask.v));
+		}
+
+		auto load(const Lockstep16& lanes) -> Words {
+			const __m256i* data = reinterpret_cast<const __m256i*>(lanes.data());
+			return { _mm256_loadu_si256(data), _mm256_loadu_si256(data + 1) };
+		}
+		auto store(Lockstep16& lanes, const Words a) -> void {
+			__m256i* data = reinterpret_cast<__m256i*>(lanes.data());
+			_mm256_storeu_si256(data, a.lo);
+			_mm256_storeu_si256(data + 1, a.hi);
+		}
+		auto words(const uint16_t value) -> Words {
+			const __m256i v = _mm256_set1_epi16(static_cast<short>(value));
+			return { v, v };
+		}
+		auto widen(const Bytes a) -> Words {
+			return {
+				_mm256_cvtepu8_epi16(_mm256_castsi256_si128(a.v)),
+				_mm256_cvtepu8_epi16(_mm256_extracti128_si256(a.v, 1)),
+			};
+		}
+		// Packs 16 bit masks back into one byte per lane.
+		auto narrow(const __m256i lo, const __m256i hi) -> Bytes {
+			return { _mm256_permute4x64_epi64(_mm256_packs_epi16(lo, hi), 0b11'01'10'00) };
+		}
+		auto operator +(const Words a, const Words b) -> Words {
+			return { _mm256_add_epi16(a.lo, b.lo), _mm256_add_epi16(a.hi, b.hi) };
+		}
+		auto operator -(const Words a, const Words b) -> Words {
+			return { _mm256_sub_epi16(a.lo, b.lo), _mm256_sub_epi16(a.hi, b.hi) };
+		}
+		auto equal(const Words a, const Words b) -> Bytes {
+			return narrow(_mm256_cmpeq_epi16(a.lo, b.lo), _mm256_cmpeq_epi16(a.hi, b.hi));
+		}
+		auto at_least(const Words a, const Words b) -> Bytes {
+			return narrow(
+				_mm256_cmpeq_epi16(_mm256_max_epu16(a.lo, b.lo), a.lo),
+				_mm256_cmpeq_epi16(_mm256_max_epu16(a.hi, b.hi), a.hi));
+		}
+		auto select(const Bytes mask, const Words a, const Words b) -> Words {
+			const __m256i lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(mask.v));
+			const __m256i hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(mask.v, 1));
+			return { _mm256_blendv_epi8(b.lo, a.lo, lo), _mm256_blendv_epi8(b.hi, a.hi, hi) };
+		}
+		// Index of the first lane holding the largest value.
+		auto first_max(const Words a) -> int {
+			const __m256i wide = _mm256_max_epu16(a.lo, a.hi);
+			const __m128i half = _mm_max_epu16(_mm256_castsi256_si128(wide), _mm256_extracti128_si256(wide, 1));
+			// minpos only finds minimums, so search the complement.
+			const __m128i complement = _mm_xor_si128(half, _mm_set1_epi16(-1));
+			const uint16_t top = static_cast<uint16_t>(~_mm_cvtsi128_si32(_mm_minpos_epu16(complement)));
+			return std::countr_zero(bits(equal(a, words(top))));
+		}
+#else
+		struct Bytes {
+			Lockstep8 v;
+		};
+		struct Words {
+			Lockstep16 v;
+		};
+
+		template<typename Result, typename Function>
+		auto lanewise(Function&& function) -> Result {
+			Result result{};
+			for (int lane = 0; lane < Lockstep::LANES; lane++) {
+				result.v[lane] = function(lane);
+			}
+			return result;
+		}
+		auto mask(const bool condition) -> uint8_t {
+			return condition ? 0xFF : 0;
+		}
+
+		auto load(const Lockstep8& lanes) -> Bytes {
+			return { lanes };
+		}
+		auto store(Lockstep8& lanes, const Bytes a) -> void {
+			lanes = a.v;
+		}
+		auto bytes(const uint8_t value) -> Bytes {
+			Bytes result;
+			result.v.fill(value);
+			return result;
+		}
+		auto operator +(const Bytes a, const Bytes b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return static_cast<uint8_t>(a.v[i] + b.v[i]); });
+		}
+		auto operator -(const Bytes a, const Bytes b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return static_cast<uint8_t>(a.v[i] - b.v[i]); });
+		}
+		auto operator &(const Bytes a, const Bytes b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return static_cast<uint8_t>(a.v[i] & b.v[i]); });
+		}
+		auto operator |(const Bytes a, const Bytes b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return static_cast<uint8_t>(a.v[i] | b.v[i]); });
+		}
+		auto operator ^(const Bytes a, const Bytes b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return static_cast<uint8_t>(a.v[i] ^ b.v[i]); });
+		}
+		auto equal(const Bytes a, const Bytes b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return mask(a.v[i] == b.v[i]); });
+		}
+		auto at_least(const Bytes a, const Bytes b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return mask(a.v[i] >= b.v[i]); });
+		}
+		auto shift_right(const Bytes a) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return static_cast<uint8_t>(a.v[i] >> 1); });
+		}
+		auto saturating_sub(const Bytes a, const Bytes b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return static_cast<uint8_t>(std::max(a.v[i] - b.v[i], 0)); });
+		}
+		auto select(const Bytes mask, const Bytes a, const Bytes b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return mask.v[i] & 0x80 ? a.v[i] : b.v[i]; });
+		}
+		auto bits(const Bytes mask) -> uint32_t {
+			uint32_t result = 0;
+			for (int lane = 0; lane < Lockstep::LANES; lane++) {
+				result |= static_cast<uint32_t>(mask.v[lane] >> 7) << lane;
+			}
+			return result;
+		}
+
+		auto load(const Lockstep16& lanes) -> Words {
+			return { lanes };
+		}
+		auto store(Lockstep16& lanes, const Words a) -> void {
+			lanes = a.v;
+		}
+		auto words(const uint16_t value) -> Words {
+			Words result;
+			result.v.fill(value);
+			return result;
+		}
+		auto widen(const Bytes a) -> Words {
+			return lanewise<Words>([&](const int i) { return static_cast<uint16_t>(a.v[i]); });
+		}
+		auto operator +(const Words a, const Words b) -> Words {
+			return lanewise<Words>([&](const int i) { return static_cast<uint16_t>(a.v[i] + b.v[i]); });
+		}
+		auto operator -(const Words a, const Words b) -> Words {
+			return lanewise<Words>([&](const int i) { return static_cast<uint16_t>(a.v[i] - b.v[i]); });
+		}
+		auto equal(const Words a, const Words b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return mask(a.v[i] == b.v[i]); });
+		}
+		auto at_least(const Words a, const Words b) -> Bytes {
+			return lanewise<Bytes>([&](const int i) { return mask(a.v[i] >= b.v[i]); });
+		}
+		auto select(const Bytes mask, const Words a, const Words b) -> Words {
+			return lanewise<Words>([&](const int i) { return mask.v[i] & 0x80 ? a.v[i] : b.v[i]; });
+		}
+		auto first_max(const Words a) -> int {
+			return static_cast<int>(std::ranges::max_element(a.v) - a.v.begin());
+		}
+#endif
+	}
+
+
+	Lockstep::Lockstep()
+		: m_RAM(RAM_SIZE), m_displayMemory(LANES)
+	{
+		m_decoded.fill(Chip8::decode(0));
+		for (int lane = 0; lane < LANES; lane++) {
+			m_seeds[lane] = lane + 1;
+		}
+		set_settings(m_settings);
+		reset();
+	}
+
+	// Like Chip8's, a ROM that cannot be loaded leaves the previous one running.
+	auto Lockstep::load_program(const fs::path& path) -> bool {
+		if (!fs::exists(path)) {
+			return 0;
+		}
+
+		if (fs::file_size(path) > RAM_SIZE - 0x200) {
+			return 0;
+		}
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			return 0;
+		}
+
+		std::array<uint8_t, RAM_SIZE> memory{};
+		file.read(reinterpret_cast<char*>(memory.data() + 0x200), RAM_SIZE - 0x200);
+		if (file.bad()) {
+			return 0;
+		}
+		file.close();
+		std::ranges::copy(Chip8::FONT, memory.begin() + Chip8::FONT_ADDRESS);
+		std::ranges::copy(Chip8::BIG_FONT, memory.begin() + Chip8::BIG_FONT_ADDRESS);
+
+		for (int address = 0; address < RAM_SIZE; address++) {
+			m_RAM[address].fill(memory[address]);
+			m_opcodes[address] = memory[address] << 8 | memory[(address + 1) & (RAM_SIZE - 1)];
+			m_decoded[address] = Chip8::decode(m_opcodes[address]);
+		}
+		std::fill(m_displayMemory.begin(), m_displayMemory.end(), Chip8::DisplayMemory{});
+
+		reset();
+		m_halted = 0;
+		return 1;
+	}
+	auto Lockstep::reset() -> void {
+		m_V = {};
+		m_PC.fill(0x200);
+		m_I = {};
+		m_delay = {};
+		m_sound = {};
+		m_playSound = {};
+		m_tick = {};
+		m_stack = {};
+		m_sp = {};
+		m_heldKey.fill(-1);
+		for (int lane = 0; lane < LANES; lane++) {
+			semantics::seed_random(m_random[lane], m_seeds[lane]);
+		}
+	}
+	auto Lockstep::set_settings(const Chip8::Settings& settings) -> void {
+		static constexpr auto runners = []<size_t... Profile>(std::index_sequence<Profile...>) {
+			return std::array<Runner, Chip8::QUIRK_PROFILES>{ &Lockstep::run_lanes<Chip8::quirks_of(Profile)>... };
+			}(std::make_index_sequence<Chip8::QUIRK_PROFILES>{});
+
+		m_settings = settings;
+		m_run = runners[Chip8::quirk_profile(settings)];
+	}
+	auto Lockstep::set_seed(const int lane, const uint64_t seed) -> void {
+		m_seeds[lane] = seed;
+		semantics::seed_random(m_random[lane], seed);
+	}
+	auto Lockstep::get_registers(const int lane) const -> CPU::Registers {
+		CPU::Registers registers{ .PC = m_PC[lane], .I = m_I[lane], .delay = m_delay[lane], .sound = m_sound[lane] };
+		for (int i = 0; i < 16; i++) {
+			registers.V[i] = m_V[i][lane];
+		}
+		return registers;
+	}
+	auto Lockstep::set_registers(const int lane, const CPU::Registers& registers) -> void {
+		m_PC[lane] = registers.PC;
+		m_I[lane] = registers.I;
+		m_delay[lane] = registers.delay;
+		m_sound[lane] = registers.sound;
+		for (int i = 0; i < 16; i++) {
+			m_V[i][lane] = registers.V[i];
+		}
+	}
+
+	auto Lockstep::run(const int cycles) -> void {
+		if (m_halted) return;
+
+		(this->*m_run)(cycles);
+	}
+	template<Chip8::Quirks Q>
+	auto Lockstep::run_lanes(const int cycles) -> void {
+		for (int left = cycles; left > 0;) {
+			const uint16_t chunk = static_cast<uint16_t>(std::min(left, 0xFFFF));
+			left -= chunk;
+			store(m_remaining, words(chunk));
+
+			while (true) {
+				// The lane furthest behind picks the next instruction, which keeps diverged groups in step.
+				const Words remaining = load(m_remaining);
+				const int leader = first_max(remaining);
+				if (m_remaining[leader] == 0) break;
+
+				// PC can point past 0xFFF after a skip or BNNN, like Chip8 the fetch wraps it.
+				const uint16_t pc = m_PC[leader];
+				const uint16_t address = pc & (RAM_SIZE - 1);
+				const uint16_t next = (address + 1) & (RAM_SIZE - 1);
+				const uint8_t high = m_RAM[address][leader];
+				const uint8_t low = m_RAM[next][leader];
+
+				// Lanes run together when they are at the same address and see the same opcode there.
+				const Bytes group = at_least(remaining, words(1))
+					& equal(load(m_PC), words(pc))
+					& equal(load(m_RAM[address]), bytes(high))
+					& equal(load(m_RAM[next]), bytes(low));
+
+				store(m_PC, select(group, words((pc + 2) & 0xFFF), load(m_PC)));
+				store(m_remaining, select(group, remaining + words(0xFFFF), remaining));
+
+				Lanes<uint8_t> mask;
+				store(mask, group);
+				execute<Q>(decode(address, high << 8 | low), mask);
+
+				// Each instruction moves the timer phase on by TIMER_FREQUENCY, the timers count down when
+				// it passes INSTRUCTIONS_PER_SECOND.
+				const Words tick = select(group, load(m_tick) + words(Chip8::TIMER_FREQUENCY), load(m_tick));
+				const Bytes due = at_least(tick, words(Chip8::INSTRUCTIONS_PER_SECOND));
+				const Bytes sound = saturating_sub(load(m_sound), due & bytes(1));
+				store(m_delay, saturating_sub(load(m_delay), due & bytes(1)));
+				store(m_sound, sound);
+				store(m_playSound, select(due, (equal(sound, bytes(0)) ^ bytes(0xFF)) & bytes(1), load(m_playSound)));
+				store(m_tick, select(due, tick - words(Chip8::INSTRUCTIONS_PER_SECOND), tick));
+			}
+		}
+	}
+	auto Lockstep::decode(const uint16_t address, const uint16_t opcode) -> Instruction {
+		// Lanes share the decoded program until one of them rewrites it.
+		if (m_opcodes[address] != opcode) {
+			m_opcodes[address] = opcode;
+			m_decoded[address] = Chip8::decode(opcode);
+		}
+		return m_decoded[address];
+	}
+
+	// Vector operations below do what the functions in semantics do for one lane, the comparison with
+	// Chip8 in tests/Lockstep.cpp keeps them in line.
+	template<Chip8::Quirks Q>
+	auto Lockstep::execute(const Instruction instruction, const Lanes<uint8_t>& mask) -> void {
+		const Bytes group = load(mask);
+		Lanes<uint8_t>& vx = m_V[instruction.vx];
+		Lanes<uint8_t>& vf = m_V[0xF];
+		const Bytes x = load(vx);
+		const Bytes y = load(m_V[instruction.vy]);
+
+		auto set = [&](Lanes<uint8_t>& target, const Bytes value) -> void {
+			store(target, select(group, value, load(target)));
+		};
+		auto set_flag = [&](const Bytes condition) -> void {
+			store(vf, select(group, condition & bytes(1), load(vf)));
+		};
+		auto skip_if = [&](const Bytes condition) -> void {
+			const Words pc = load(m_PC);
+			store(m_PC, select(group & condition, pc + words(2), pc));
+		};
+		auto for_each_lane = [&](auto&& function) -> void {
+			for (uint32_t lanes = bits(group); lanes; lanes &= lanes - 1) {
+				function(std::countr_zero(lanes));
+			}
+		};
+
+		switch (instruction.op) {
+			using enum Opcode;
+		case UNKNOWN:
+		case NOP:
+			break;
+		case CLEAR:
+			for_each_lane([&](const int lane) { m_displayMemory[lane] = {}; });
+			break;
+		case RET:
+			for_each_lane([&](const int lane) {
+				m_PC[lane] = m_sp[lane] ? m_stack[--m_sp[lane]][lane] : 0;
+				});
+			break;
+		case JP:
+			store(m_PC, select(group, words(instruction.address), load(m_PC)));
+			break;
+		case CALL:
+			for_each_lane([&](const int lane) {
+				if (m_sp[lane] < 16) m_stack[m_sp[lane]++][lane] = m_PC[lane];
+				m_PC[lane] = instruction.address;
+				});
+			break;
+		case SKIP_VX_EQ_NN:
+			skip_if(equal(x, bytes(instruction.literal)));
+			break;
+		case SKIP_VX_NEQ_NN:
+			skip_if(equal(x, bytes(instruction.literal)) ^ bytes(0xFF));
+			break;
+		case SKIP_VX_EQ_VY:
+			skip_if(equal(x, y));
+			break;
+		case SKIP_VX_NEQ_VY:
+			skip_if(equal(x, y) ^ bytes(0xFF));
+			break;
+		case VX_SET:
+			set(vx, bytes(instruction.literal));
+			break;
+		case VX_ADD:
+			set(vx, x + bytes(instruction.literal));
+			break;
+		case SET_VX_TO_VY:
+			set(vx, y);
+			break;
+		case OR_VX_WITH_VY:
+			set(vx, x | y);
+			break;
+		case AND_VX_WITH_VY:
+			set(vx, x & y);
+			break;
+		case XOR_VX_WITH_VY:
+			set(vx, x ^ y);
+			break;
+		case ADD_VY_TO_VX: {
+			const Bytes sum = x + y;
+			set(vx, sum);
+			set_flag(at_least(sum, x) ^ bytes(0xFF));
+			break;
+		}
+		case SUB_VY_FROM_VX:
+			set(vx, x - y);
+			set_flag(at_least(x, y));
+			break;
+		case SUB_VX_FROM_VY:
+			set(vx, y - x);
+			set_flag(at_least(y, x));
+			break;
+		case SR_VX_BY_VY: {
+			const Bytes value = Q.putVYintoVXbeforeShift ? y : x;
+			set(vx, shift_right(value));
+			set_flag(value);
+			break;
+		}
+		case SL_VX_BY_VY: {
+			const Bytes value = Q.putVYintoVXbeforeShift ? y : x;
+			set(vx, value + value);
+			set_flag(at_least(value, bytes(0x80)));
+			break;
+		}
+		case SET_I:
+			store(m_I, select(group, words(instruction.address), load(m_I)));
+			break;
+		case JR: {
+			const Bytes offset = Q.useVXinsteadOfV0 ? x : load(m_V[0]);
+			store(m_PC, select(group, widen(offset) + words(instruction.address), load(m_PC)));
+			break;
+		}
+		case RANDOM:
+			for_each_lane([&](const int lane) { vx[lane] = semantics::next_random(m_random[lane]) & instruction.literal; });
+			break;
+		case DRAW:
+			for_each_lane([&](const int lane) { draw<Q>(instruction, lane); });
+			break;
+		case KEY_PRESSED:
+		case KEY_NOT_PRESSED: {
+			const bool expected = instruction.op == KEY_PRESSED;
+			for_each_lane([&](const int lane) {
+				if ((m_keys[lane] >> (vx[lane] & 0xF) & 1) == expected) {
+					m_PC[lane] += 2;
+				}
+				});
+			break;
+		}
+		case SET_VX_TO_DELAY:
+			set(vx, load(m_delay));
+			break;
+		case WAIT_FOR_KEYPRESS:
+			for_each_lane([&](const int lane) {
+				const int key = semantics::wait_for_keypress(m_heldKey[lane], m_keys[lane]);
+				if (key >= 0) vx[lane] = static_cast<uint8_t>(key);
+				else m_PC[lane] -= 2;
+				});
+			break;
+		case SET_DELAY_TO_VX:
+			set(m_delay, x);
+			break;
+		case SET_SOUND_TO_VX:
+			set(m_sound, x);
+			break;
+		case ADD_VX_TO_I: {
+			const Words I = load(m_I);
+			const Words sum = I + widen(x);
+			store(m_I, select(group, sum, I));
+			// Only leaving the 12 bit range sets VF.
+			const Bytes leaving = at_least(words(0xFFF), I) & at_least(sum, words(0x1000));
+			store(vf, select(group & leaving, bytes(1), load(vf)));
+			break;
+		}
+		case SET_I_TO_HEX_CHARACTER: {
+			const Bytes digit = x & bytes(0xF);
+			const Bytes twice = digit + digit;
+			const Bytes offset = twice + twice + digit;
+			store(m_I, select(group, widen(offset) + words(Chip8::FONT_ADDRESS), load(m_I)));
+			break;
+		}
+		case BCD_VX:
+			for_each_lane([&](const int lane) {
+				const std::array<uint8_t, 3> digits = semantics::bcd(vx[lane]);
+				for (int i = 0; i < 3; i++) {
+					m_RAM[(m_I[lane] + i) & (RAM_SIZE - 1)][lane] = digits[i];
+				}
+				});
+			break;
+		case SAVE_VX:
+			for_each_lane([&](const int lane) {
+				CPU::Registers registers = get_registers(lane);
+				semantics::save_registers<Q.changeValueOfI>(registers, instruction.vx, [&](const int offset, const uint8_t value) {
+					m_RAM[(registers.I + offset) & (RAM_SIZE - 1)][lane] = value;
+					});
+				set_registers(lane, registers);
+				});
+			break;
+		case LOAD_VX:
+			for_each_lane([&](const int lane) {
+				std::array<uint8_t, 16> source{};
+				for (int i = 0; i <= instruction.vx; i++) {
+					source[i] = m_RAM[(m_I[lane] + i) & (RAM_SIZE - 1)][lane];
+				}
+				CPU::Registers registers = get_registers(lane);
+				semantics::load_registers<Q.changeValueOfI>(registers, instruction.vx, source.data());
+				set_registers(lane, registers);
+				});
+			break;
+		default:
+			// Everything beyond plain CHIP-8 is left out.
+			break;
+		}
+	}
+
+	template<Chip8::Quirks Q>
+	auto Lockstep::draw(const Instruction instruction, const int lane) -> void {
+		// Outside the vertical blank the draw repeats until the next tick, like Chip8's display wait.
+		if constexpr (Q.displayWait) {
+			if (m_tick[lane] >= Chip8::TIMER_FREQUENCY) {
+				m_PC[lane] = (m_PC[lane] - 2) & 0xFFF;
+				return;
+			}
+		}
+
+		const int x = m_V[instruction.vx][lane] & (Chip8::DISPLAY_X - 1);
+		const int y = m_V[instruction.vy][lane] & (Chip8::DISPLAY_Y - 1);
+		const bool large = (instruction.literal & 0xF) == 0 && Q.largeSprites;
+		const int rows = large ? 16 : instruction.literal & 0xF;
+
+		// Gather the sprite out of the interleaved memory.
+		std::array<uint8_t, 32> sprite{};
+		for (int i = 0; i < (large ? 32 : rows); i++) {
+			sprite[i] = m_RAM[(m_I[lane] + i) & (RAM_SIZE - 1)][lane];
+		}
+		const uint64_t collision = semantics::draw_sprite<Q.clipping>(m_displayMemory[lane], sprite.data(), x, y, rows, large, 0);
+		m_V[0xF][lane] = collision != 0;
+	}
+}
@@ -0,0 +1,188 @@
+#include "Chip8/Memory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#include <cstdlib>
+#endif
+
+namespace ks {
+	static std::atomic<uint64_t> copies;
+	// Live images by the hash of their ROM. Instances may load ROMs from different threads.
+	static std::mutex imagesMutex;
+	static std::unordered_multimap<uint64_t, std::weak_ptr<const MemoryImage>> images;
+
+	// FNV-1a.
+	static auto hash(const std::span<const uint8_t> bytes) -> uint64_t {
+		uint64_t value = 0xCBF29CE484222325;
+		for (const uint8_t byte : bytes) {
+			value = (value ^ byte) * 0x100000001B3;
+		}
+		return value;
+	}
+
+	// Zeroed pages straight from the OS, they take no physical memory until they are touched.
+	static auto allocate(const size_t size) -> uint8_t* {
+#if defined(_WIN32)
+		return static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#elif defined(__linux__)
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		return memory == MAP_FAILED ? nullptr : static_cast<uint8_t*>(memory);
+#else
+		return static_cast<uint8_t*>(std::calloc(size, 1));
+#endif
+	}
+	static auto deallocate(uint8_t* memory, const size_t size) -> void {
+#if defined(_WIN32)
+		VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(__linux__)
+		munmap(memory, size);
+#else
+		std::free(memory);
+#endif
+	}
+
+	MemoryImage::MemoryImage(const std::span<const uint8_t> rom, const std::span<const uint8_t> bytes, std::vector<Instruction> decoded)
+		: m_size(bytes.size()), m_rom(rom.begin(), rom.end()), m_decoded(std::move(decoded)) {
+#if defined(_WIN32)
+		const uint64_t size = m_size;
+		if (HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr)) {
+			if (void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, m_size)) {
+				std::memcpy(view, bytes.data(), m_size);
+				m_bytes = static_cast<const uint8_t*>(view);
+				m_handle = reinterpret_cast<intptr_t>(mapping);
+				return;
+			}
+			CloseHandle(mapping);
+		}
+#elif defined(__linux__)
+		const int descriptor = memfd_create("chip8-image", MFD_CLOEXEC);
+		if (descriptor >= 0) {
+			void* view = ftruncate(descriptor, static_cast<off_t>(m_size)) == 0
+				? mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0)
+				: MAP_FAILED;
+			if (view != MAP_FAILED) {
+				std::memcpy(view, bytes.data(), m_size);
+				m_bytes = static_cast<const uint8_t*>(view);
+				m_handle = descriptor;
+				return;
+			}
+			close(descriptor);
+		}
+#endif
+		m_copy.assign(bytes.begin(), bytes.end());
+		m_bytes = m_copy.data();
+	}
+	MemoryImage::~MemoryImage() {
+		if (m_handle == -1) return;
+#if defined(_WIN32)
+		UnmapViewOfFile(m_bytes);
+		CloseHandle(reinterpret_cast<HANDLE>(m_handle));
+#elif defined(__linux__)
+		munmap(const_cast<uint8_t*>(m_bytes), m_size);
+		close(static_cast<int>(m_handle));
+#endif
+	}
+
+	auto MemoryImage::find(const std::span<const uint8_t> rom) -> std::shared_ptr<const MemoryImage> {
+		const uint64_t key = hash(rom);
+		const std::scoped_lock lock(imagesMutex);
+		return lookup(key, rom);
+	}
+	auto MemoryImage::share(const std::span<const uint8_t> rom, const std::span<const uint8_t> bytes, std::vector<Instruction> decoded) -> std::shared_ptr<const MemoryImage> {
+		const uint64_t key = hash(rom);
+		const std::scoped_lock lock(imagesMutex);
+		if (std::shared_ptr<const MemoryImage> image = lookup(key, rom)) {
+			return image;
+		}
+
+		// New ROMs are rare, the images that are gone are dropped here.
+		std::erase_if(images, [](const auto& entry) { return entry.second.expired(); });
+		std::shared_ptr<const MemoryImage> image(new MemoryImage(rom, bytes, std::move(decoded)));
+		images.emplace(key, image);
+		return image;
+	}
+	auto MemoryImage::lookup(const uint64_t hash, const std::span<const uint8_t> rom) -> std::shared_ptr<const MemoryImage> {
+		const auto [begin, end] = images.equal_range(hash);
+		for (auto entry = begin; entry != end; ++entry) {
+			std::shared_ptr<const MemoryImage> image = entry->second.lock();
+			if (image && std::ranges::equal(image->m_rom, rom)) {
+				return image;
+			}
+		}
+		return nullptr;
+	}
+
+	Memory::Memory(const size_t size) {
+		assign(size);
+	}
+	Memory::~Memory() {
+		release();
+	}
+
+	auto Memory::assign(const size_t size) -> void {
+		release();
+		m_data = allocate(size);
+		if (!m_data) {
+			throw std::bad_alloc();
+		}
+		m_size = size;
+	}
+	auto Memory::map(std::shared_ptr<const MemoryImage> image) -> void {
+		release();
+#if defined(_WIN32)
+		if (image->m_handle != -1) {
+			m_data = static_cast<uint8_t*>(MapViewOfFile(reinterpret_cast<HANDLE>(image->m_handle), FILE_MAP_COPY, 0, 0, image->m_size));
+		}
+#elif defined(__linux__)
+		if (image->m_handle != -1) {
+			void* view = mmap(nullptr, image->m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, static_cast<int>(image->m_handle), 0);
+			m_data = view == MAP_FAILED ? nullptr : static_cast<uint8_t*>(view);
+		}
+#endif
+		if (m_data) {
+			m_size = image->m_size;
+			m_image = std::move(image);
+			return;
+		}
+
+		// Nothing to map, this instance gets a copy of its own. Said once, the count tells how many.
+		if (copies++ == 0) {
+			std::cerr << "[MEMORY] ROM image can not be mapped, instances copy it instead of sharing.\n";
+		}
+		assign(image->m_size);
+		std::memcpy(m_data, image->m_bytes, m_size);
+	}
+	auto Memory::get_copy_count() -> uint64_t {
+		return copies;
+	}
+	auto Memory::release() -> void {
+		if (!m_data) return;
+
+		if (m_image) {
+#if defined(_WIN32)
+			UnmapViewOfFile(m_data);
+#elif defined(__linux__)
+			munmap(m_data, m_size);
+#endif
+			m_image.reset();
+		}
+		else {
+			deallocate(m_data, m_size);
+		}
+		m_data = nullptr;
+		m_size = 0;
+	}
+}
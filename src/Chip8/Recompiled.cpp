@@ -0,0 +1,24 @@
+#include "Chip8/Recompiled.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace ks {
+	static auto programs() -> std::vector<RecompiledProgram>& {
+		static std::vector<RecompiledProgram> registered;
+		return registered;
+	}
+
+	auto register_recompiled_program(const RecompiledProgram& program) -> bool {
+		programs().push_back(program);
+		return 1;
+	}
+	auto find_recompiled_program(const std::span<const uint8_t> rom) -> const RecompiledProgram* {
+		for (const RecompiledProgram& program : programs()) {
+			if (std::ranges::equal(program.rom, rom)) {
+				return &program;
+			}
+		}
+		return nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "Chip8/Scheduler.hpp"
+
+namespace ks {
+	auto Scheduler::add(Chip8& chip8) -> int {
+		auto instance = std::make_unique<Instance>();
+		instance->chip8 = &chip8;
+		instance->task = drive(chip8, instance->keys);
+
+		const int index = static_cast<int>(m_instances.size());
+		m_instances.push_back(std::move(instance));
+		m_running.push_back(index);
+		return index;
+	}
+	auto Scheduler::set_keys(const int index, const uint16_t keys) -> void {
+		Instance& instance = *m_instances[index];
+		const bool changed = instance.keys != keys;
+		instance.keys = keys;
+
+		if (instance.state == State::WAITING_FOR_KEY && changed) {
+			// The timers kept running while it slept, as they would have while FX0A repeated.
+			instance.chip8->skip_ticks(static_cast<int>(m_tick - instance.suspendedAt));
+			instance.state = State::RUNNING;
+			m_running.push_back(index);
+		}
+	}
+	auto Scheduler::run_tick() -> void {
+		m_tick++;
+
+		m_next.clear();
+		for (const int index : m_running) {
+			Instance& instance = *m_instances[index];
+			instance.state = instance.task.resume();
+
+			switch (instance.state) {
+			case State::RUNNING:
+				m_next.push_back(index);
+				break;
+			case State::WAITING_FOR_KEY:
+				instance.suspendedAt = m_tick;
+				break;
+			case State::HALTED:
+				break;
+			}
+		}
+		std::swap(m_running, m_next);
+	}
+
+	auto Scheduler::drive(Chip8& chip8, const uint16_t& keys) -> Task {
+		while (!chip8.is_halted()) {
+			chip8.run_cycles(chip8.get_cycles_to_tick(), keys);
+			co_yield chip8.is_waiting_for_key() ? State::WAITING_FOR_KEY : State::RUNNING;
+		}
+	}
+}
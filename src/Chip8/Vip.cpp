@@ -0,0 +1,374 @@
+#include "Chip8/Vip.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+namespace ks {
+	namespace {
+		// CDP1861 timing, in scanlines. The interrupt comes 29 machine cycles before the first DMA so the
+		// interpreter's handler can set R0 up in time, EF1 marks the four lines around either end. DMA is
+		// requested on the second cycle of a display line, and the 1802 grants it once its current machine
+		// cycle ends, so it always comes before any instruction that starts on the line.
+		constexpr int INTERRUPT_LINE = 78;
+		constexpr int DISPLAY_START = 80;
+		constexpr int DISPLAY_END = DISPLAY_START + Vip::DISPLAY_Y;
+		constexpr int DMA_LENGTH = 8;
+
+		// Long branches and skips take a third machine cycle for the second operand byte.
+		constexpr auto CYCLES = []() {
+			std::array<uint8_t, 256> table{};
+			for (int opcode = 0; opcode < 256; opcode++) {
+				table[opcode] = (opcode >> 4) == 0xC ? 3 : 2;
+			}
+			return table;
+			}();
+	}
+
+	Vip::Vip() {
+		reset();
+	}
+
+	auto Vip::load_program(const fs::path& interpreter, const fs::path& program) -> bool {
+		const std::optional<std::vector<uint8_t>> image = read_image(interpreter, program);
+		if (!image) {
+			m_image = {};
+			m_halted = 1;
+			return 0;
+		}
+		return load_image(*image);
+	}
+	auto Vip::read_image(const fs::path& interpreter, const fs::path& program) -> std::optional<std::vector<uint8_t>> {
+		if (!fs::exists(interpreter) || !fs::exists(program)) {
+			return std::nullopt;
+		}
+		if (fs::file_size(interpreter) > INTERPRETER_SIZE || fs::file_size(program) > RAM_SIZE - PROGRAM_START) {
+			return std::nullopt;
+		}
+
+		std::ifstream interpreterFile(interpreter, std::ios::binary);
+		std::ifstream programFile(program, std::ios::binary);
+		if (!interpreterFile || !programFile) {
+			return std::nullopt;
+		}
+
+		std::vector<uint8_t> image(RAM_SIZE);
+		interpreterFile.read(reinterpret_cast<char*>(image.data()), INTERPRETER_SIZE);
+		programFile.read(reinterpret_cast<char*>(image.data() + PROGRAM_START), RAM_SIZE - PROGRAM_START);
+		return image;
+	}
+	auto Vip::load_image(const std::span<const uint8_t> image) -> bool {
+		m_image = {};
+		m_halted = 1;
+		if (image.size() != RAM_SIZE) {
+			return 0;
+		}
+
+		std::ranges::copy(image, m_image.begin());
+		reset();
+		m_halted = 0;
+		return 1;
+	}
+	auto Vip::reset() -> void {
+		m_RAM = m_image;
+		m_displayMemory = {};
+
+		// State the monitor ROM leaves behind when it hands over to RAM: P = X = 0 with R0 at 0000, and
+		// R1 pointing at the top of memory, where the interpreter keeps its stack and display.
+		m_R = {};
+		m_R[1] = RAM_SIZE - 1;
+		m_D = 0;
+		m_P = 0;
+		m_X = 0;
+		m_T = 0;
+		m_DF = 0;
+		m_Q = 0;
+		m_IE = 1;
+		m_idle = 0;
+
+		m_line = 0;
+		m_displayEnabled = 0;
+		m_cycles = 0;
+		m_lineStart = 0;
+		m_targetCycles = 0;
+		m_keyLatch = 0;
+	}
+	auto Vip::run_cycles(const int cycles, const uint16_t keypad) -> void {
+		if (m_halted) return;
+
+		m_keys = keypad;
+		m_targetCycles += cycles;
+		while (m_lineStart + CYCLES_PER_LINE <= m_targetCycles) {
+			run_line();
+		}
+	}
+
+	auto Vip::run_line() -> void {
+		if (m_line == INTERRUPT_LINE && m_displayEnabled && m_IE) {
+			interrupt();
+		}
+
+		if (m_line >= DISPLAY_START && m_line < DISPLAY_END) {
+			const int row = m_line - DISPLAY_START;
+			if (m_displayEnabled) {
+				dma(row);
+			}
+			else {
+				m_displayMemory[row] = 0;
+			}
+		}
+
+		m_lineStart += CYCLES_PER_LINE;
+		execute_until(m_lineStart);
+		if (++m_line == LINES) {
+			m_line = 0;
+		}
+	}
+	auto Vip::execute_until(const uint64_t target) -> void {
+		// One handler per opcode byte, with the register number already baked in.
+		static constexpr auto handlers = []<size_t... OPCODES>(std::index_sequence<OPCODES...>) {
+			return std::array<Handler, 256>{ &Vip::execute<static_cast<uint8_t>(OPCODES)>... };
+		}(std::make_index_sequence<256>());
+
+		while (m_cycles < target) {
+			// IDL waits for the next DMA or interrupt, nothing else can happen before then.
+			if (m_idle) {
+				m_cycles = target;
+				return;
+			}
+			const uint8_t opcode = read(m_R[m_P]++);
+			(this->*handlers[opcode])();
+			m_cycles += CYCLES[opcode];
+		}
+	}
+	auto Vip::interrupt() -> void {
+		m_T = m_X << 4 | m_P;
+		m_P = 1;
+		m_X = 2;
+		m_IE = 0;
+		m_idle = 0;
+		m_cycles++;
+	}
+	auto Vip::dma(const int row) -> void {
+		uint64_t pixels = 0;
+		for (int i = 0; i < DMA_LENGTH; i++) {
+			pixels = pixels << 8 | read(m_R[0]++);
+		}
+		m_displayMemory[row] = pixels;
+		m_idle = 0;
+		m_cycles += DMA_LENGTH;
+	}
+
+	auto Vip::output(const int port, const uint8_t value) -> void {
+		switch (port) {
+		case 1: m_displayEnabled = 0; break;
+		case 2: m_keyLatch = value & 0xF; break;
+		}
+	}
+	auto Vip::input(const int port) -> uint8_t {
+		if (port == 1) {
+			m_displayEnabled = 1;
+		}
+		return 0;
+	}
+
+	// EF1 is the 1861's display status, EF3 the keypad key selected by OUT 2. EF2 and EF4 are the
+	// cassette input and the IN button, neither of which is connected here.
+	template<int N>
+	auto Vip::flag() const -> bool {
+		if constexpr (N == 1) {
+			return (m_line >= INTERRUPT_LINE - 2 && m_line < DISPLAY_START) || (m_line >= DISPLAY_END - 4 && m_line < DISPLAY_END);
+		}
+		else if constexpr (N == 3) {
+			return m_keys >> m_keyLatch & 1;
+		}
+		else {
+			return 0;
+		}
+	}
+
+	template<uint8_t OPCODE>
+	auto Vip::execute() -> void {
+		constexpr int N = OPCODE & 0xF;
+		constexpr int GROUP = OPCODE >> 4;
+
+		// Short and long branch conditions, the upper half of each group tests the opposite. Long skips
+		// C5-C7 and CD-CF test Q, D == 0 and DF like the long branches below them.
+		constexpr int CONDITION = GROUP == 0xC && (N & 4) ? N & 3 : N & 7;
+		auto condition = [&]() -> bool {
+			if constexpr (CONDITION == 0) return 1;
+			else if constexpr (CONDITION == 1) return m_Q;
+			else if constexpr (CONDITION == 2) return m_D == 0;
+			else if constexpr (CONDITION == 3) return m_DF;
+			else return flag<CONDITION - 3>();
+			};
+		// Memory operand of the arithmetic groups, M(RX) or the immediate byte at M(RP).
+		auto operand = [&]() -> uint8_t {
+			if constexpr (N & 8) return read(m_R[m_P]++);
+			else return read(m_R[m_X]);
+			};
+		auto add = [&](const int a, const int b, const int carry) -> void {
+			const int sum = a + b + carry;
+			m_D = static_cast<uint8_t>(sum);
+			m_DF = sum > 0xFF;
+		};
+		// DF is set when there is no borrow.
+		auto subtract = [&](const int a, const int b, const int borrow) -> void {
+			const int difference = a - b - borrow;
+			m_D = static_cast<uint8_t>(difference);
+			m_DF = difference >= 0;
+		};
+		auto return_from = [&](const bool enable) -> void {
+			const uint8_t value = read(m_R[m_X]++);
+			m_X = value >> 4;
+			m_P = value & 0xF;
+			m_IE = enable;
+		};
+
+		if constexpr (OPCODE == 0x00) {
+			m_idle = 1;
+		}
+		else if constexpr (GROUP == 0x0) {
+			m_D = read(m_R[N]);
+		}
+		else if constexpr (GROUP == 0x1) {
+			m_R[N]++;
+		}
+		else if constexpr (GROUP == 0x2) {
+			m_R[N]--;
+		}
+		else if constexpr (GROUP == 0x3) {
+			uint16_t& pc = m_R[m_P];
+			if (condition() != static_cast<bool>(N & 8)) {
+				pc = (pc & 0xFF00) | read(pc);
+			}
+			else {
+				pc++;
+			}
+		}
+		else if constexpr (GROUP == 0x4) {
+			m_D = read(m_R[N]++);
+		}
+		else if constexpr (GROUP == 0x5) {
+			write(m_R[N], m_D);
+		}
+		else if constexpr (OPCODE == 0x60) {
+			m_R[m_X]++;
+		}
+		else if constexpr (OPCODE >= 0x61 && OPCODE <= 0x67) {
+			output(N, read(m_R[m_X]++));
+		}
+		else if constexpr (OPCODE >= 0x69 && OPCODE <= 0x6F) {
+			const uint8_t value = input(N & 7);
+			write(m_R[m_X], value);
+			m_D = value;
+		}
+		else if constexpr (GROUP == 0x6) {
+			// 68 is not an instruction on the 1802.
+		}
+		else if constexpr (OPCODE == 0x70 || OPCODE == 0x71) {
+			return_from(OPCODE == 0x70);
+		}
+		else if constexpr (OPCODE == 0x72) {
+			m_D = read(m_R[m_X]++);
+		}
+		else if constexpr (OPCODE == 0x73) {
+			write(m_R[m_X]--, m_D);
+		}
+		else if constexpr (OPCODE == 0x74 || OPCODE == 0x7C) {
+			add(operand(), m_D, m_DF);
+		}
+		else if constexpr (OPCODE == 0x75 || OPCODE == 0x7D) {
+			subtract(operand(), m_D, !m_DF);
+		}
+		else if constexpr (OPCODE == 0x76) {
+			const bool carry = m_DF;
+			m_DF = m_D & 1;
+			m_D = m_D >> 1 | carry << 7;
+		}
+		else if constexpr (OPCODE == 0x77 || OPCODE == 0x7F) {
+			subtract(m_D, operand(), !m_DF);
+		}
+		else if constexpr (OPCODE == 0x78) {
+			write(m_R[m_X], m_T);
+		}
+		else if constexpr (OPCODE == 0x79) {
+			m_T = m_X << 4 | m_P;
+			write(m_R[2]--, m_T);
+			m_X = m_P;
+		}
+		else if constexpr (OPCODE == 0x7A || OPCODE == 0x7B) {
+			m_Q = OPCODE == 0x7B;
+		}
+		else if constexpr (OPCODE == 0x7E) {
+			const bool carry = m_DF;
+			m_DF = m_D >> 7;
+			m_D = static_cast<uint8_t>(m_D << 1 | carry);
+		}
+		else if constexpr (GROUP == 0x8) {
+			m_D = static_cast<uint8_t>(m_R[N]);
+		}
+		else if constexpr (GROUP == 0x9) {
+			m_D = m_R[N] >> 8;
+		}
+		else if constexpr (GROUP == 0xA) {
+			m_R[N] = (m_R[N] & 0xFF00) | m_D;
+		}
+		else if constexpr (GROUP == 0xB) {
+			m_R[N] = static_cast<uint16_t>(m_D << 8 | (m_R[N] & 0xFF));
+		}
+		else if constexpr (GROUP == 0xC) {
+			uint16_t& pc = m_R[m_P];
+			if constexpr (N & 4) {
+				// Long skips: C4 is NOP, CC tests IE, the rest skip on the condition or its opposite.
+				const bool taken = [&]() -> bool {
+					if constexpr (N == 0x4) return 0;
+					else if constexpr (N == 0xC) return m_IE;
+					else return condition() == static_cast<bool>(N & 8);
+					}();
+				if (taken) pc += 2;
+			}
+			else if (condition() != static_cast<bool>(N & 8)) {
+				pc = static_cast<uint16_t>(read(pc) << 8 | read(pc + 1));
+			}
+			else {
+				pc += 2;
+			}
+		}
+		else if constexpr (GROUP == 0xD) {
+			m_P = N;
+		}
+		else if constexpr (GROUP == 0xE) {
+			m_X = N;
+		}
+		else if constexpr (N == 0x0 || N == 0x8) {
+			m_D = operand();
+		}
+		else if constexpr (N == 0x1 || N == 0x9) {
+			m_D |= operand();
+		}
+		else if constexpr (N == 0x2 || N == 0xA) {
+			m_D &= operand();
+		}
+		else if constexpr (N == 0x3 || N == 0xB) {
+			m_D ^= operand();
+		}
+		else if constexpr (N == 0x4 || N == 0xC) {
+			add(operand(), m_D, 0);
+		}
+		else if constexpr (N == 0x5 || N == 0xD) {
+			subtract(operand(), m_D, 0);
+		}
+		else if constexpr (N == 0x6) {
+			m_DF = m_D & 1;
+			m_D >>= 1;
+		}
+		else if constexpr (N == 0xE) {
+			m_DF = m_D >> 7;
+			m_D <<= 1;
+		}
+		else {
+			subtract(m_D, operand(), 0);
+		}
+	}
+}
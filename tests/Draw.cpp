@@ -0,0 +1,86 @@
+// The packed display has to end up with the same pixels and collisions as drawing one pixel at a time
+// into a plain array, the way the emulator first did it.
+
+#include "Test.hpp"
+
+#include "Chip8/Semantics.hpp"
+
+#include <format>
+
+namespace {
+	constexpr int DRAWS = 200000;
+
+	using Pixels = std::array<std::array<bool, ks::Chip8::HIGH_RES_DISPLAY_Y>, ks::Chip8::HIGH_RES_DISPLAY_X>;
+
+	// One pixel at a time, clipped at the edges or wrapped around them.
+	auto draw_pixels(Pixels& pixels, const uint8_t* sprite, const int x, const int y, const int rows, const bool large, const bool highResolution, const bool clipping) -> bool {
+		const int width = highResolution ? ks::Chip8::HIGH_RES_DISPLAY_X : ks::Chip8::DISPLAY_X;
+		const int height = highResolution ? ks::Chip8::HIGH_RES_DISPLAY_Y : ks::Chip8::DISPLAY_Y;
+		const int columns = large ? 16 : 8;
+
+		bool collision = 0;
+		for (int i = 0; i < rows; i++) {
+			const int row = y + i;
+			if (clipping && row >= height) break;
+
+			const int bits = large ? sprite[i * 2] << 8 | sprite[i * 2 + 1] : sprite[i];
+			for (int j = 0; j < columns; j++) {
+				const int column = x + j;
+				if (clipping && column >= width) break;
+
+				if (!(bits >> (columns - 1 - j) & 1)) continue;
+				bool& pixel = pixels[column % width][row % height];
+				collision |= pixel;
+				pixel = !pixel;
+			}
+		}
+		return collision;
+	}
+}
+
+auto main() -> int {
+	using ks::test::check;
+
+	std::mt19937 generator(1);
+	for (int draw = 0; draw < DRAWS; draw++) {
+		const bool highResolution = generator() % 2;
+		const bool clipping = generator() % 2;
+		const bool large = generator() % 4 == 0;
+		const int width = highResolution ? ks::Chip8::HIGH_RES_DISPLAY_X : ks::Chip8::DISPLAY_X;
+		const int height = highResolution ? ks::Chip8::HIGH_RES_DISPLAY_Y : ks::Chip8::DISPLAY_Y;
+
+		// Start from a random screen, so there is something to collide with.
+		Pixels pixels{};
+		ks::Chip8::DisplayMemory display{};
+		for (int i = 0; i < 40; i++) {
+			const int x = generator() % width;
+			const int y = generator() % height;
+			pixels[x][y] = 1;
+			display[y][x >> 6] |= uint64_t{ 1 } << (63 - (x & 63));
+		}
+
+		std::array<uint8_t, 32> sprite;
+		for (uint8_t& byte : sprite) {
+			byte = static_cast<uint8_t>(generator());
+		}
+		const int x = generator() % width;
+		const int y = generator() % height;
+		const int rows = large ? 16 : generator() % 16;
+
+		const bool expected = draw_pixels(pixels, sprite.data(), x, y, rows, large, highResolution, clipping);
+		const uint64_t collision = clipping
+			? ks::semantics::draw_sprite<1>(display, sprite.data(), x, y, rows, large, highResolution)
+			: ks::semantics::draw_sprite<0>(display, sprite.data(), x, y, rows, large, highResolution);
+
+		bool same = (collision != 0) == expected;
+		for (int row = 0; row < ks::Chip8::HIGH_RES_DISPLAY_Y; row++) {
+			for (int column = 0; column < ks::Chip8::HIGH_RES_DISPLAY_X; column++) {
+				same &= ks::Chip8::is_pixel_set(display[row], column) == pixels[column][row];
+			}
+		}
+		const std::string what = std::format("draw {}: {}x{} sprite at {}, {}, high resolution {}, clipping {}",
+			draw, large ? 16 : 8, rows, x, y, static_cast<int>(highResolution), static_cast<int>(clipping));
+		if (!check(same, what)) break;
+	}
+	return ks::test::result();
+}
@@ -0,0 +1,86 @@
+// Every Lockstep lane has to end each frame exactly where a Chip8 given the same ROM, settings, seed
+// and keypad does, whatever the other lanes are doing.
+
+#include "Test.hpp"
+
+#include "Chip8/Lockstep.hpp"
+
+#include <format>
+#include <memory>
+
+namespace {
+	constexpr int FRAMES = 300;
+
+	auto compare(const fs::path& rom, const ks::Chip8::Settings& settings, const std::string_view name) -> void {
+		using ks::test::check;
+
+		auto lockstep = std::make_unique<ks::Lockstep>();
+		lockstep->set_settings(settings);
+		std::vector<std::unique_ptr<ks::Chip8>> scalars;
+		for (int lane = 0; lane < ks::Lockstep::LANES; lane++) {
+			lockstep->set_seed(lane, 1000 + lane);
+
+			auto& chip8 = scalars.emplace_back(std::make_unique<ks::Chip8>());
+			chip8->set_seed(1000 + lane);
+			chip8->set_settings(settings);
+			// The scalar side runs on every engine that does not need a recompiled ROM.
+			chip8->set_engine(static_cast<ks::Chip8::Engine>(lane % 3));
+			check(chip8->load_program(rom), std::format("{}: Chip8 loads the ROM", name));
+		}
+		if (!check(lockstep->load_program(rom), std::format("{}: Lockstep loads the ROM", name))) return;
+
+		// Lanes hold keys for a few frames at a time, each lane its own sequence.
+		std::mt19937 generator(7);
+		std::array<uint16_t, ks::Lockstep::LANES> keys{};
+		for (int frame = 0; frame < FRAMES; frame++) {
+			for (int lane = 0; lane < ks::Lockstep::LANES; lane++) {
+				if (generator() % 4 == 0) {
+					keys[lane] = generator() % 3 ? static_cast<uint16_t>(1 << generator() % 16) : 0;
+				}
+				lockstep->set_keys(lane, keys[lane]);
+			}
+
+			const int cycles = lockstep->get_cycles_to_tick();
+			lockstep->run(cycles);
+			for (int lane = 0; lane < ks::Lockstep::LANES; lane++) {
+				ks::Chip8& chip8 = *scalars[lane];
+				check(chip8.get_cycles_to_tick() == cycles, std::format("{}: frame {} lane {} runs as long", name, frame, lane));
+				chip8.run_cycles(cycles, keys[lane]);
+
+				const ks::CPU::Registers expected = chip8.get_registers();
+				const ks::CPU::Registers actual = lockstep->get_registers(lane);
+				const bool same = check(actual.V == expected.V && actual.PC == expected.PC && actual.I == expected.I
+					&& actual.delay == expected.delay && actual.sound == expected.sound,
+					std::format("{}: frame {} lane {} registers, PC {:03X} vs {:03X}", name, frame, lane, actual.PC, expected.PC))
+					&& check(lockstep->get_display_memory(lane) == chip8.get_display_memory(0),
+						std::format("{}: frame {} lane {} display", name, frame, lane))
+					&& check(lockstep->should_play_sound(lane) == chip8.should_play_sound(),
+						std::format("{}: frame {} lane {} sound", name, frame, lane));
+				if (!same) return;
+			}
+		}
+	}
+}
+
+auto main() -> int {
+	const fs::path tetris = fs::path(DATA_PATH) / "newtetris.ch8";
+	std::vector<fs::path> roms{ tetris };
+	for (uint32_t seed = 1; seed <= 4; seed++) {
+		roms.push_back(ks::test::write_rom(std::format("lockstep{}.ch8", seed), ks::test::random_program(seed, 60)));
+	}
+
+	for (size_t profile = 0; profile < ks::Chip8::QUIRK_PROFILES; profile++) {
+		const ks::Chip8::Quirks quirks = ks::Chip8::quirks_of(profile);
+		ks::Chip8::Settings settings{};
+		settings.putVYintoVXbeforeShift = quirks.putVYintoVXbeforeShift;
+		settings.useVXinsteadOfV0 = quirks.useVXinsteadOfV0;
+		settings.changeValueOfI = quirks.changeValueOfI;
+		settings.clipping = quirks.clipping;
+		settings.displayWait = quirks.displayWait;
+		settings.largeSprites = quirks.largeSprites;
+		for (const fs::path& rom : roms) {
+			compare(rom, settings, std::format("{} profile {}", rom.filename().string(), profile));
+		}
+	}
+	return ks::test::result();
+}
@@ -0,0 +1,92 @@
+// Instances of one ROM share its image copy-on-write: a write stays private to the instance that made it,
+// and where the OS can map the image nobody falls back to a full copy. The decoded instructions are
+// shared the same way, until self-modifying code gives an instance its own.
+
+#include "Test.hpp"
+
+#include "Chip8/Memory.hpp"
+
+#include <format>
+#include <memory>
+
+namespace {
+	// With key 0 held, rewrites the V2 = 5 at 206 to V2 = 9 before running it.
+	const std::vector<uint16_t> SELF_MODIFYING{
+		0x6100, // V1 = 0
+		0xE1A1, // skip if key V1 is not held
+		0x2210, // call the patch
+		0x6205, // V2 = 5
+		0x1208, // stay here
+		0x0000,
+		0x0000,
+		0x0000,
+		0xA206, // I = 206
+		0x6062, // V0 = 62
+		0x6109, // V1 = 09
+		0xF155, // store V0, V1 at I
+		0x00EE, // return
+	};
+
+	auto test_decoded() -> void {
+		using ks::test::check;
+
+		const fs::path rom = ks::test::write_rom("memory.ch8", SELF_MODIFYING);
+		std::array<ks::Chip8, 3> instances;
+		for (ks::Chip8& chip8 : instances) {
+			check(chip8.load_program(rom), "loads the ROM");
+		}
+		instances[0].run_frame(1);
+		instances[1].run_frame(0);
+		check(instances[0].get_registers().V[2] == 9, std::format("the patched instance runs its own code, V2 = {}", instances[0].get_registers().V[2]));
+		check(instances[0].has_own_decoded(), "writing into code copies the decoded instructions");
+		check(instances[1].get_registers().V[2] == 5, std::format("the others do not see it, V2 = {}", instances[1].get_registers().V[2]));
+		check(!instances[1].has_own_decoded(), "instances that do not write into code share them");
+
+		// Loaded after the patch, from the image and not from the instance that changed its memory.
+		check(instances[2].load_program(rom), "loads the ROM again");
+		instances[2].run_frame(0);
+		check(instances[2].get_registers().V[2] == 5 && !instances[2].has_own_decoded(), "a later instance starts from the image");
+	}
+}
+
+auto main() -> int {
+	using ks::test::check;
+
+	std::vector<uint8_t> bytes(ks::Chip8::RAM_SIZE);
+	for (size_t i = 0; i < bytes.size(); i++) {
+		bytes[i] = static_cast<uint8_t>(i * 7);
+	}
+	const std::span<const uint8_t> rom(bytes.data() + 0x200, 0x100);
+	check(ks::MemoryImage::find(rom) == nullptr, "there is no image before one is made");
+	const std::shared_ptr<const ks::MemoryImage> image = ks::MemoryImage::share(rom, bytes, {});
+	check(ks::MemoryImage::find(rom) == image && ks::MemoryImage::share(rom, bytes, {}) == image, "the same ROM shares one image");
+	std::vector<uint8_t> other(rom.begin(), rom.end());
+	other.back() ^= 1;
+	check(ks::MemoryImage::find(other) == nullptr, "a different ROM has no image");
+
+	std::vector<std::unique_ptr<ks::Memory>> instances;
+	for (int i = 0; i < 16; i++) {
+		instances.push_back(std::make_unique<ks::Memory>(0x1000));
+		instances.back()->map(image);
+	}
+	(*instances[3])[0x300] = 0xAB;
+
+	for (size_t i = 0; i < instances.size(); i++) {
+		const ks::Memory& memory = *instances[i];
+		if (!check(memory.size() == bytes.size(), std::format("instance {} has the image's size", i))) continue;
+
+		size_t differences = 0;
+		for (size_t address = 0; address < bytes.size(); address++) {
+			differences += memory[address] != bytes[address];
+		}
+		check(differences == (i == 3 ? 1 : 0) && (i != 3 || memory[0x300] == 0xAB), std::format("instance {} sees the image and only its own write", i));
+	}
+	check(std::ranges::equal(image->get_bytes(), bytes), "writes never reach the image");
+
+#if defined(_WIN32) || defined(__linux__)
+	check(ks::Memory::get_copy_count() == 0, std::format("{} instances copied the image instead of mapping it", ks::Memory::get_copy_count()));
+#endif
+
+	test_decoded();
+	return ks::test::result();
+}
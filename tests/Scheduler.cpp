@@ -0,0 +1,78 @@
+// An instance suspended in FX0A has to wake up as if it had been polled every tick: timers down by the
+// ticks it slept through and the key that woke it in VX.
+
+#include "Test.hpp"
+
+#include "Chip8/Scheduler.hpp"
+
+#include <format>
+
+namespace {
+	constexpr int SLEEP_TICKS = 20;
+
+	const std::vector<uint16_t> WAIT_FOR_KEY{
+		0x6050, // V0 = 80
+		0xF015, // DT = V0
+		0xF018, // ST = V0
+		0xF30A, // V3 = key
+		0x1208, // stay here
+	};
+}
+
+auto main() -> int {
+	using ks::test::check;
+	using State = ks::Scheduler::State;
+
+	const fs::path rom = ks::test::write_rom("scheduler.ch8", WAIT_FOR_KEY);
+	// The same ROM run a frame at a time with the same keypad, which is what the scheduler stands in for.
+	ks::Chip8 scheduled;
+	ks::Chip8 polled;
+	check(scheduled.load_program(rom) && polled.load_program(rom), "loads the ROM");
+
+	ks::Scheduler scheduler;
+	const int instance = scheduler.add(scheduled);
+	uint16_t keys = 0;
+	auto tick = [&]() -> void {
+		scheduler.run_tick();
+		polled.run_frame(keys);
+	};
+	auto press = [&](const uint16_t pressed) -> void {
+		keys = pressed;
+		scheduler.set_keys(instance, keys);
+	};
+
+	tick();
+	check(scheduler.get_state(instance) == State::WAITING_FOR_KEY, "suspends in FX0A");
+	check(scheduler.get_running_count() == 0, "a suspended instance is not run");
+	const ks::CPU::Registers asleep = scheduled.get_registers();
+
+	for (int i = 0; i < SLEEP_TICKS; i++) {
+		tick();
+	}
+	check(scheduler.get_state(instance) == State::WAITING_FOR_KEY, "stays suspended without input");
+	check(scheduled.get_executed_instructions() < polled.get_executed_instructions(), "nothing runs while suspended");
+
+	press(1 << 7);
+	const ks::CPU::Registers awake = scheduled.get_registers();
+	check(awake.delay == asleep.delay - SLEEP_TICKS, std::format("DT {} after {} ticks from {}", awake.delay, SLEEP_TICKS, asleep.delay));
+	check(awake.sound == asleep.sound - SLEEP_TICKS, std::format("ST {} after {} ticks from {}", awake.sound, SLEEP_TICKS, asleep.sound));
+	check(scheduler.get_state(instance) == State::RUNNING, "a new keypad wakes it");
+
+	// FX0A finishes when the key is let go.
+	tick();
+	tick();
+	press(0);
+	tick();
+	tick();
+	check(scheduler.get_state(instance) == State::RUNNING, "runs on after the key is released");
+
+	const ks::CPU::Registers& actual = scheduled.get_registers();
+	const ks::CPU::Registers& expected = polled.get_registers();
+	check(actual.V[3] == 7, std::format("the key landed in V3, got {}", actual.V[3]));
+	check(actual.V == expected.V && actual.PC == expected.PC, std::format("PC {:03X} vs {:03X} polled", actual.PC, expected.PC));
+	check(actual.delay == expected.delay && actual.sound == expected.sound,
+		std::format("DT {} vs {} polled, ST {} vs {}", actual.delay, expected.delay, actual.sound, expected.sound));
+	check(scheduled.get_executed_instructions() == polled.get_executed_instructions(),
+		std::format("executed {} vs {} polled", scheduled.get_executed_instructions(), polled.get_executed_instructions()));
+	return ks::test::result();
+}
@@ -0,0 +1,107 @@
+// Skipping an idle loop has to leave an instance exactly where stepping through it does, at any rate
+// and wherever a batch ends, and count the same share of time spent waiting on the delay timer.
+
+#include "Test.hpp"
+
+#include <format>
+#include <memory>
+
+namespace {
+	constexpr int FRAMES = 600;
+
+	// Waits for the delay timer to reach 0 or 3, draws a digit and starts over with a longer delay.
+	const std::vector<uint16_t> DELAY_WAIT{
+		0x6005, // V0 = 5
+		0xF015, // DT = V0
+		0xF107, // V1 = DT
+		0x3100, // skip if V1 == 0
+		0x1204, // jump back to V1 = DT
+		0xF015, // DT = V0
+		0xF207, // V2 = DT
+		0x3203, // skip if V2 == 3
+		0x120C, // jump back to V2 = DT
+		0x7301, // V3 += 1
+		0xF329, // I = digit V3
+		0xD455, // draw it at V4, V5
+		0x7407, // V4 += 7
+		0x7009, // V0 += 9
+		0x1202, // start over
+	};
+
+	auto compare(const fs::path& rom, const int rate, const ks::Chip8::Engine engine, const std::string_view name) -> void {
+		using ks::test::check;
+
+		std::array<std::unique_ptr<ks::Chip8>, 2> instances;
+		for (int i = 0; i < 2; i++) {
+			auto& chip8 = instances[i] = std::make_unique<ks::Chip8>();
+			chip8->set_seed(5);
+			chip8->set_engine(engine);
+			chip8->set_instructions_per_second(rate);
+			chip8->set_idle_skipping(i == 0);
+			check(chip8->load_program(rom), std::format("{}: loads the ROM", name));
+		}
+		ks::Chip8& skipping = *instances[0];
+		ks::Chip8& stepping = *instances[1];
+
+		std::mt19937 generator(3);
+		uint16_t keys = 0;
+		for (int frame = 0; frame < FRAMES; frame++) {
+			if (generator() % 8 == 0) {
+				keys = generator() % 2 ? static_cast<uint16_t>(1 << generator() % 16) : 0;
+			}
+			// Whole frames, and every other frame a short batch that can end in the middle of a loop.
+			const int cycles = frame % 2 ? static_cast<int>(generator() % 40 + 1) : skipping.get_cycles_to_tick();
+			skipping.run_cycles(cycles, keys);
+			stepping.run_cycles(cycles, keys);
+
+			const ks::CPU::Registers& actual = skipping.get_registers();
+			const ks::CPU::Registers& expected = stepping.get_registers();
+			const bool same = check(actual.V == expected.V && actual.PC == expected.PC && actual.I == expected.I,
+				std::format("{}: frame {} registers, PC {:03X} vs {:03X}", name, frame, actual.PC, expected.PC))
+				&& check(actual.delay == expected.delay && actual.sound == expected.sound,
+					std::format("{}: frame {} timers, DT {} vs {}", name, frame, actual.delay, expected.delay))
+				&& check(skipping.get_executed_instructions() == stepping.get_executed_instructions(),
+					std::format("{}: frame {} executed {} vs {}", name, frame, skipping.get_executed_instructions(), stepping.get_executed_instructions()))
+				&& check(skipping.get_display_memory(0) == stepping.get_display_memory(0),
+					std::format("{}: frame {} display", name, frame))
+				&& check(skipping.get_delay_wait_instructions() == stepping.get_delay_wait_instructions(),
+					std::format("{}: frame {} delay wait {} vs {}", name, frame, skipping.get_delay_wait_instructions(), stepping.get_delay_wait_instructions()));
+			if (!same) return;
+		}
+	}
+}
+
+auto main() -> int {
+	std::vector<fs::path> roms{ ks::test::write_rom("skipidle.ch8", DELAY_WAIT) };
+	for (uint32_t seed = 1; seed <= 4; seed++) {
+		roms.push_back(ks::test::write_rom(std::format("skipidle{}.ch8", seed), ks::test::random_program(seed, 40)));
+	}
+
+	// Below 180 instructions a second an iteration can span a tick, those loops are always stepped.
+	for (const int rate : { 540, 1000, 7000, 200, 100 }) {
+		for (const auto engine : { ks::Chip8::Engine::SWITCH, ks::Chip8::Engine::THREADED, ks::Chip8::Engine::JIT }) {
+			for (const fs::path& rom : roms) {
+				compare(rom, rate, engine, std::format("{} at {} on engine {}", rom.filename().string(), rate, static_cast<int>(engine)));
+			}
+		}
+	}
+
+	// The loop has to have been skipped for the comparison to mean anything, and stepped through it has
+	// to be counted on every engine.
+	for (const auto engine : { ks::Chip8::Engine::SWITCH, ks::Chip8::Engine::THREADED, ks::Chip8::Engine::JIT }) {
+		std::array<uint64_t, 2> waits{};
+		for (int i = 0; i < 2; i++) {
+			ks::Chip8 chip8;
+			chip8.set_engine(engine);
+			chip8.set_idle_skipping(i == 0);
+			chip8.load_program(roms[0]);
+			for (int frame = 0; frame < 60; frame++) {
+				chip8.run_frame(0);
+			}
+			waits[i] = chip8.get_delay_wait_instructions();
+		}
+		ks::test::check(waits[0] > 0 && waits[0] == waits[1],
+			std::format("engine {} waits {} instructions skipping and {} stepping", static_cast<int>(engine), waits[0], waits[1]));
+	}
+	return ks::test::result();
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Chip8/Chip8.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace ks::test {
+	inline int failures = 0;
+
+	// Reports a failed check, main returns result() so the test fails.
+	inline auto check(const bool condition, const std::string_view what) -> bool {
+		if (!condition) {
+			std::cerr << "FAILED: " << what << "\n";
+			failures++;
+		}
+		return condition;
+	}
+	inline auto result() -> int {
+		if (failures) {
+			std::cerr << failures << " check(s) failed\n";
+			return 1;
+		}
+		return 0;
+	}
+
+	// load_program takes a path, so generated ROMs go through a file.
+	inline auto write_rom(const std::string_view name, const std::vector<uint16_t>& opcodes) -> fs::path {
+		const fs::path path = fs::temp_directory_path() / std::string(name);
+		std::ofstream file(path, std::ios::binary);
+		for (const uint16_t opcode : opcodes) {
+			file.put(static_cast<char>(opcode >> 8));
+			file.put(static_cast<char>(opcode & 0xFF));
+		}
+		return path;
+	}
+
+	// A random plain CHIP-8 program of length units that loops forever. I is reset to 0x800 every
+	// round, so memory operations stay clear of the code, and only leaves the 12 bit range for FX1E's
+	// flag.
+	inline auto random_program(const uint32_t seed, const int length) -> std::vector<uint16_t> {
+		std::mt19937 generator(seed);
+		auto random = [&](const int bound) -> int {
+			return static_cast<int>(generator() % bound);
+		};
+
+		std::vector<uint16_t> program;
+		auto emit = [&](const int opcode) -> void {
+			program.push_back(static_cast<uint16_t>(opcode));
+		};
+		auto address = [&]() -> int {
+			return 0x200 + static_cast<int>(program.size()) * 2;
+		};
+
+		emit(0xA800);
+		for (int unit = 0; unit < length; unit++) {
+			const int x = random(15);
+			const int y = random(16);
+			switch (random(20)) {
+			case 0: emit(0x6000 | x << 8 | random(256)); break;
+			case 1: emit(0x7000 | x << 8 | random(256)); break;
+			case 2: emit(0x8000 | x << 8 | y << 4 | random(8)); break;
+			case 3: emit(0x8006 | x << 8 | y << 4); break;
+			case 4: emit(0x800E | x << 8 | y << 4); break;
+			case 5: emit(0xC000 | x << 8 | random(256)); break;
+			case 6: emit(0x3000 | x << 8 | random(4)); break;
+			case 7: emit(0x4000 | x << 8 | random(4)); break;
+			case 8: emit((random(2) ? 0x5000 : 0x9000) | x << 8 | y << 4); break;
+			case 9: emit((random(2) ? 0xE09E : 0xE0A1) | x << 8); break;
+			case 10: emit(0xA800 | random(0x100)); break;
+			case 11: emit(0xF029 | x << 8); break;
+			case 12: emit(0xD000 | x << 8 | y << 4 | random(16)); break;
+			case 13: emit(0xF033 | x << 8); break;
+			case 14: emit((random(2) ? 0xF055 : 0xF065) | x << 8); break;
+			case 15: emit((random(2) ? 0xF015 : 0xF018) | x << 8); break;
+			case 16: emit(0xF007 | x << 8); break;
+			case 17:
+				// FX1E past 0xFFF, then back into range before anything reads memory.
+				emit(0xAF80);
+				emit(0xF01E | x << 8);
+				emit(0xA800 | random(0x100));
+				break;
+			case 18: {
+				// A short delay timer wait, the loop the interpreters fuse and skip.
+				emit(0x6000 | x << 8 | random(8));
+				emit(0xF015 | x << 8);
+				const int wait = address();
+				emit(0xF007 | x << 8);
+				emit(0x3000 | x << 8);
+				emit(0x1000 | wait);
+				break;
+			}
+			case 19:
+				if (random(4) == 0) emit(0xF00A | x << 8);
+				else emit(0x00E0);
+				break;
+			}
+		}
+		// Twice, in case the last unit skips the first one.
+		emit(0x1200);
+		emit(0x1200);
+		return program;
+	}
+}
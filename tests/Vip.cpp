@@ -0,0 +1,196 @@
+// Hand-assembled 1802 sequences, run as the interpreter image: every short and long branch and skip
+// under every combination of the flags it can test, and the carry and borrow of the arithmetic group.
+// The expected results are written out from the CDP1802 manual rather than derived from Vip.
+
+#include "Test.hpp"
+
+#include "Chip8/Vip.hpp"
+
+#include <format>
+
+namespace {
+	// Results are stored here, R3 points at it.
+	constexpr uint16_t RESULT = 0x0F00;
+	constexpr int CYCLES = 2000;
+
+	struct Flags {
+		bool Q{};
+		bool zero{};
+		bool DF{};
+		bool IE{};
+		// EF3, the keypad key selected by OUT 2, key 0 after reset.
+		bool key{};
+	};
+
+	enum class Layout : uint8_t {
+		// 3N NN, taken jumps within the page.
+		SHORT_BRANCH,
+		// CN HH LL.
+		LONG_BRANCH,
+		// CN, taken jumps over the next two bytes.
+		LONG_SKIP,
+	};
+
+	auto layout_of(const uint8_t opcode) -> Layout {
+		if (opcode >> 4 == 0x3) return Layout::SHORT_BRANCH;
+		return opcode & 4 ? Layout::LONG_SKIP : Layout::LONG_BRANCH;
+	}
+
+	// Whether the branch or skip is taken, from the instruction tables of the manual. EF1 is low outside
+	// the lines around the display, EF2 and EF4 are not connected.
+	auto taken(const uint8_t opcode, const Flags& flags) -> bool {
+		switch (opcode) {
+		case 0x30: return 1; // BR
+		case 0x31: return flags.Q; // BQ
+		case 0x32: return flags.zero; // BZ
+		case 0x33: return flags.DF; // BDF
+		case 0x34: return 0; // B1
+		case 0x35: return 0; // B2
+		case 0x36: return flags.key; // B3
+		case 0x37: return 0; // B4
+		case 0x38: return 0; // SKP, skips its operand byte
+		case 0x39: return !flags.Q; // BNQ
+		case 0x3A: return !flags.zero; // BNZ
+		case 0x3B: return !flags.DF; // BNF
+		case 0x3C: return 1; // BN1
+		case 0x3D: return 1; // BN2
+		case 0x3E: return !flags.key; // BN3
+		case 0x3F: return 1; // BN4
+		case 0xC0: return 1; // LBR
+		case 0xC1: return flags.Q; // LBQ
+		case 0xC2: return flags.zero; // LBZ
+		case 0xC3: return flags.DF; // LBDF
+		case 0xC4: return 0; // NOP
+		case 0xC5: return !flags.Q; // LSNQ
+		case 0xC6: return !flags.zero; // LSNZ
+		case 0xC7: return !flags.DF; // LSNF
+		case 0xC8: return 0; // LSKP, skips its two operand bytes
+		case 0xC9: return !flags.Q; // LBNQ
+		case 0xCA: return !flags.zero; // LBNZ
+		case 0xCB: return !flags.DF; // LBNF
+		case 0xCC: return flags.IE; // LSIE
+		case 0xCD: return flags.Q; // LSQ
+		case 0xCE: return flags.zero; // LSZ
+		case 0xCF: return flags.DF; // LSDF
+		}
+		return 0;
+	}
+
+	auto write_bytes(const std::string_view name, const std::vector<uint8_t>& bytes) -> fs::path {
+		const fs::path path = fs::temp_directory_path() / std::string(name);
+		std::ofstream file(path, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		return path;
+	}
+
+	// Runs code from 0000 until it idles and returns the bytes it stored from RESULT on.
+	auto run(const std::vector<uint8_t>& code, const uint16_t keys) -> std::array<uint8_t, 2> {
+		static const fs::path program = write_bytes("vip_empty.ch8", {});
+		ks::Vip vip;
+		if (!ks::test::check(vip.load_program(write_bytes("vip_code.bin", code), program), "loads the code")) return {};
+		vip.run_cycles(CYCLES, keys);
+		return { vip.get_memory()[RESULT], vip.get_memory()[RESULT + 1] };
+	}
+
+	// R3 = RESULT, D and DF are set up after it.
+	auto prologue() -> std::vector<uint8_t> {
+		return {
+			0xF8, RESULT >> 8, 0xB3, // LDI, PHI R3
+			0xF8, RESULT & 0xFF, 0xA3, // LDI, PLO R3
+		};
+	}
+	// LDI 80 or 00, SHL.
+	auto set_DF(std::vector<uint8_t>& code, const bool DF) -> void {
+		code.insert(code.end(), { 0xF8, static_cast<uint8_t>(DF ? 0x80 : 0x00), 0xFE });
+	}
+
+	auto test_branch(const uint8_t opcode, const Flags& flags) -> void {
+		std::vector<uint8_t> code = prologue();
+		if (!flags.IE) {
+			// DIS with X = P = 0 reads its operand inline: X = 0, P = 0.
+			code.insert(code.end(), { 0x71, 0x00 });
+		}
+		code.push_back(flags.Q ? 0x7B : 0x7A); // SEQ or REQ
+		set_DF(code, flags.DF);
+		code.insert(code.end(), { 0xF8, static_cast<uint8_t>(flags.zero ? 0x00 : 0x05) }); // LDI
+
+		// Not taken stores 1, taken stores 2. Everything stays in page 0.
+		const uint8_t branch = static_cast<uint8_t>(code.size());
+		const uint8_t notTaken = branch + 8;
+		const uint8_t takenPath = branch + 12;
+		const uint8_t store = branch + 16;
+		switch (layout_of(opcode)) {
+		case Layout::SHORT_BRANCH:
+			code.insert(code.end(), { opcode, takenPath, 0x30, notTaken });
+			break;
+		case Layout::LONG_BRANCH:
+			code.insert(code.end(), { opcode, 0x00, takenPath, 0x30, notTaken });
+			break;
+		case Layout::LONG_SKIP:
+			// Skipping lands on the jump to the taken path, falling through takes the one below it.
+			code.insert(code.end(), { opcode, 0x30, notTaken, 0x30, takenPath });
+			break;
+		}
+		code.resize(notTaken, 0x00);
+		code.insert(code.end(), { 0xF8, 0x01, 0x30, store }); // not taken: LDI 1, BR store
+		code.insert(code.end(), { 0xF8, 0x02, 0x30, store }); // taken: LDI 2, BR store
+		code.insert(code.end(), { 0x53, 0x00 }); // STR R3, IDL
+
+		const uint8_t result = run(code, flags.key ? 1 : 0)[0];
+		ks::test::check(result == (taken(opcode, flags) ? 2 : 1),
+			std::format("{:02X} with Q={} D={} DF={} IE={} EF3={}: stored {}", opcode,
+				static_cast<int>(flags.Q), flags.zero ? 0 : 5, static_cast<int>(flags.DF), static_cast<int>(flags.IE), static_cast<int>(flags.key), result));
+	}
+
+	// D = a, M = b with DF as the carry in, then stores D and DF.
+	auto test_arithmetic(const uint8_t opcode, const uint8_t a, const uint8_t b, const bool DF) -> void {
+		const bool immediate = opcode & 8;
+		const bool withCarry = opcode >> 4 == 0x7;
+		const int borrow = withCarry && !DF;
+		int result = 0;
+		switch (opcode & 7) {
+		case 4: result = a + b + (withCarry && DF); break; // ADD, ADC: D + M
+		case 5: result = b - a - borrow; break; // SD, SDB: M - D
+		case 7: result = a - b - borrow; break; // SM, SMB: D - M
+		}
+		// Add carries out above 0xFF, subtraction sets DF when nothing was borrowed.
+		const bool expectedDF = (opcode & 7) == 4 ? result > 0xFF : result >= 0;
+
+		std::vector<uint8_t> code = prologue();
+		if (!immediate) {
+			// R4 = RESULT + 0x10 holding b, X = 4.
+			code.insert(code.end(), { 0xF8, RESULT >> 8, 0xB4, 0xF8, (RESULT & 0xFF) + 0x10, 0xA4, 0xF8, b, 0x54, 0xE4 });
+		}
+		set_DF(code, DF);
+		code.insert(code.end(), { 0xF8, a, opcode });
+		if (immediate) code.push_back(b);
+		// STR R3, INC R3, LDI 0, SHLC puts DF into D, STR R3, IDL.
+		code.insert(code.end(), { 0x53, 0x13, 0xF8, 0x00, 0x7E, 0x53, 0x00 });
+
+		const std::array<uint8_t, 2> stored = run(code, 0);
+		ks::test::check(stored[0] == static_cast<uint8_t>(result) && stored[1] == expectedDF,
+			std::format("{:02X} with D={:02X} M={:02X} DF={}: D={:02X} DF={}, expected D={:02X} DF={}", opcode, a, b, static_cast<int>(DF),
+				stored[0], stored[1], static_cast<uint8_t>(result), static_cast<int>(expectedDF)));
+	}
+}
+
+auto main() -> int {
+	for (int opcode = 0x30; opcode <= 0xCF; opcode++) {
+		if (opcode == 0x40) opcode = 0xC0;
+		for (int bits = 0; bits < 32; bits++) {
+			const Flags flags{ .Q = (bits & 1) != 0, .zero = (bits & 2) != 0, .DF = (bits & 4) != 0, .IE = (bits & 8) != 0, .key = (bits & 16) != 0 };
+			test_branch(static_cast<uint8_t>(opcode), flags);
+		}
+	}
+
+	constexpr std::array<uint8_t, 6> VALUES{ 0x00, 0x01, 0x35, 0x7F, 0x80, 0xFF };
+	for (const uint8_t opcode : { 0x74, 0x7C, 0x75, 0x7D, 0x77, 0x7F, 0xF4, 0xFC, 0xF5, 0xFD, 0xF7, 0xFF }) {
+		for (const uint8_t a : VALUES) {
+			for (const uint8_t b : VALUES) {
+				test_arithmetic(opcode, a, b, 0);
+				test_arithmetic(opcode, a, b, 1);
+			}
+		}
+	}
+	return ks::test::result();
+}
@@ -0,0 +1,72 @@
+// chip8-batch: runs one ROM in every Lockstep lane, each lane with its own seed and random input, and
+// prints where every lane ended up.
+// Usage: chip8-batch <rom.ch8> [frames] [seed]
+
+#include "Chip8/Lockstep.hpp"
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace {
+	// FNV-1a over the display rows.
+	auto hash(const ks::Chip8::DisplayMemory& display) -> uint64_t {
+		uint64_t result = 0xCBF29CE484222325;
+		for (const ks::Chip8::DisplayRow& row : display) {
+			for (const uint64_t word : row) {
+				result = (result ^ word) * 0x100000001B3;
+			}
+		}
+		return result;
+	}
+}
+
+auto main(int argc, char** argv) -> int {
+	if (argc < 2) {
+		std::cerr << "Usage: chip8-batch <rom.ch8> [frames] [seed]\n";
+		return 1;
+	}
+	const int frames = argc > 2 ? std::stoi(argv[2]) : 600;
+	const uint64_t seed = argc > 3 ? std::stoull(argv[3]) : 1;
+
+	auto lockstep = std::make_unique<ks::Lockstep>();
+	for (int lane = 0; lane < ks::Lockstep::LANES; lane++) {
+		lockstep->set_seed(lane, seed + lane);
+	}
+	if (!lockstep->load_program(argv[1])) {
+		std::cerr << std::format("Failed to load {}\n", argv[1]);
+		return 1;
+	}
+
+	// Every lane holds a random key, or none, for a few frames at a time.
+	std::mt19937_64 generator(seed);
+	std::array<uint16_t, ks::Lockstep::LANES> keys{};
+	int64_t instructions = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		for (int lane = 0; lane < ks::Lockstep::LANES; lane++) {
+			if (generator() % 8 == 0) {
+				keys[lane] = generator() % 2 ? static_cast<uint16_t>(1 << generator() % 16) : 0;
+			}
+			lockstep->set_keys(lane, keys[lane]);
+		}
+
+		const int cycles = lockstep->get_cycles_to_tick();
+		lockstep->run(cycles);
+		instructions += cycles;
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	for (int lane = 0; lane < ks::Lockstep::LANES; lane++) {
+		const ks::CPU::Registers registers = lockstep->get_registers(lane);
+		std::cout << std::format("lane {:2} PC={:03X} I={:03X} display={:016x}\n",
+			lane, registers.PC, registers.I, hash(lockstep->get_display_memory(lane)));
+	}
+	const double rate = instructions * ks::Lockstep::LANES / std::max(elapsed.count(), 1e-9);
+	std::cout << std::format("{} frames in {:.3f} s, {:.1f}M instructions per second over all lanes\n",
+		frames, elapsed.count(), rate / 1e6);
+	return 0;
+}
@@ -0,0 +1,308 @@
+// chip8-recomp: translates a CHIP-8 ROM into a C++ translation unit with one function per basic block.
+// Usage: chip8-recomp <rom.ch8> <output.cpp>
+
+#include "Chip8/Chip8.hpp"
+#include "Chip8/Semantics.hpp"
+
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
+
+namespace {
+	constexpr int PROGRAM_START = 0x200;
+	constexpr int MAX_BLOCK_LENGTH = ks::Jit::MAX_BLOCK_LENGTH;
+
+	struct Rom {
+		std::vector<uint8_t> bytes;
+
+		auto contains(const uint16_t address) const -> bool {
+			return address >= PROGRAM_START && address + 1 < PROGRAM_START + static_cast<int>(bytes.size());
+		}
+		auto opcode(const uint16_t address) const -> uint16_t {
+			return bytes[address - PROGRAM_START] << 8 | bytes[address + 1 - PROGRAM_START];
+		}
+	};
+
+	struct Block {
+		uint16_t address{};
+		int length{};
+		int timerIndex{ -1 };
+		int drawIndex{ -1 };
+		std::string body;
+	};
+
+	auto is_terminator(const ks::Opcode op) -> bool {
+		switch (op) {
+			using enum ks::Opcode;
+		case RET:
+		case JP:
+		case CALL:
+		case SKIP_VX_EQ_NN:
+		case SKIP_VX_NEQ_NN:
+		case SKIP_VX_EQ_VY:
+		case SKIP_VX_NEQ_VY:
+		case JR:
+		case KEY_PRESSED:
+		case KEY_NOT_PRESSED:
+		case WAIT_FOR_KEYPRESS:
+		case BCD_VX:
+		case SAVE_VX:
+		case EXIT:
+		case SET_I_LONG:
+		case SAVE_VX_TO_VY:
+		// MEGA-CHIP switches engines, and 01NN NNNN reads its operand at PC.
+		case MEGA_OFF:
+		case MEGA_ON:
+		case SET_I_MEGA:
+			return 1;
+		default:
+			return 0;
+		}
+	}
+
+	// Where a skip at address lands, a skipped F000 NNNN is four bytes long.
+	auto skip_target(const Rom& rom, const uint16_t address) -> uint16_t {
+		const uint16_t next = (address + 2) & 0xFFF;
+		const bool isLong = rom.contains(next) && ks::Chip8::decode(rom.opcode(next)).op == ks::Opcode::SET_I_LONG;
+		return (next + (isLong ? 4 : 2)) & 0xFFF;
+	}
+
+	// Successors of an instruction that are known before running the program. BNNN has none.
+	auto successors(const Rom& rom, const uint16_t address, const ks::Instruction instruction) -> std::vector<uint16_t> {
+		const uint16_t next = (address + 2) & 0xFFF;
+		switch (instruction.op) {
+			using enum ks::Opcode;
+		case RET:
+		case JR:
+		case EXIT:
+			return {};
+		case JP:
+			return { instruction.address };
+		case CALL:
+			return { instruction.address, next };
+		case SKIP_VX_EQ_NN:
+		case SKIP_VX_NEQ_NN:
+		case SKIP_VX_EQ_VY:
+		case SKIP_VX_NEQ_VY:
+		case KEY_PRESSED:
+		case KEY_NOT_PRESSED:
+			return { next, skip_target(rom, address) };
+		case SET_I_LONG:
+			return { static_cast<uint16_t>((next + 2) & 0xFFF) };
+		case SET_I_MEGA:
+			// Only MEGA-CHIP mode gives it an operand to step over.
+			return { next, static_cast<uint16_t>((next + 2) & 0xFFF) };
+		default:
+			return { next };
+		}
+	}
+
+	auto translate(const Rom& rom, const uint16_t address, const ks::Instruction instruction, const uint16_t opcode) -> std::string {
+		const int x = instruction.vx;
+		const int y = instruction.vy;
+		const int nn = instruction.literal;
+		const int nnn = instruction.address;
+		const uint16_t next = (address + 2) & 0xFFF;
+		const uint16_t skipped = skip_target(rom, address);
+
+		switch (instruction.op) {
+			using enum ks::Opcode;
+		case NOP:
+			return "";
+		case JP:
+			return std::format("r.PC = {:#05x};", nnn);
+		case SKIP_VX_EQ_NN:
+			return std::format("r.PC = V[{}] == {:#04x} ? {:#05x} : {:#05x};", x, nn, skipped, next);
+		case SKIP_VX_NEQ_NN:
+			return std::format("r.PC = V[{}] != {:#04x} ? {:#05x} : {:#05x};", x, nn, skipped, next);
+		case SKIP_VX_EQ_VY:
+			return std::format("r.PC = V[{}] == V[{}] ? {:#05x} : {:#05x};", x, y, skipped, next);
+		case SKIP_VX_NEQ_VY:
+			return std::format("r.PC = V[{}] != V[{}] ? {:#05x} : {:#05x};", x, y, skipped, next);
+		case VX_SET:
+			return std::format("V[{}] = {:#04x};", x, nn);
+		case VX_ADD:
+			return std::format("V[{}] += {:#04x};", x, nn);
+		case SET_VX_TO_VY:
+			return std::format("V[{}] = V[{}];", x, y);
+		case OR_VX_WITH_VY:
+			return std::format("V[{}] |= V[{}];", x, y);
+		case AND_VX_WITH_VY:
+			return std::format("V[{}] &= V[{}];", x, y);
+		case XOR_VX_WITH_VY:
+			return std::format("V[{}] ^= V[{}];", x, y);
+		case ADD_VY_TO_VX:
+			return std::format("{{ const int sum = V[{0}] + V[{1}]; V[{0}] = static_cast<uint8_t>(sum); V[0xF] = sum > 255; }}", x, y);
+		case SUB_VY_FROM_VX:
+			return std::format("{{ const bool flag = V[{0}] >= V[{1}]; V[{0}] -= V[{1}]; V[0xF] = flag; }}", x, y);
+		case SUB_VX_FROM_VY:
+			return std::format("{{ const bool flag = V[{1}] >= V[{0}]; V[{0}] = V[{1}] - V[{0}]; V[0xF] = flag; }}", x, y);
+		case SR_VX_BY_VY:
+			return std::format("{{ const uint8_t value = context.shiftUsesVY ? V[{1}] : V[{0}]; V[{0}] = value >> 1; V[0xF] = value & 0x1; }}", x, y);
+		case SL_VX_BY_VY:
+			return std::format("{{ const uint8_t value = context.shiftUsesVY ? V[{1}] : V[{0}]; V[{0}] = value << 1; V[0xF] = value >> 7; }}", x, y);
+		case SET_I:
+			return std::format("r.I = {:#05x};", nnn);
+		case SET_VX_TO_DELAY:
+			return std::format("V[{}] = r.delay;", x);
+		case SET_DELAY_TO_VX:
+			return std::format("r.delay = V[{}];", x);
+		case SET_SOUND_TO_VX:
+			return std::format("r.sound = V[{}];", x);
+		case ADD_VX_TO_I:
+			return std::format("{{ const bool inRange = r.I <= 0xFFF; r.I += V[{}]; if (inRange && r.I > 0xFFF) V[0xF] = 1; }}", x);
+		case SET_I_TO_HEX_CHARACTER:
+			return std::format("r.I = 0x50 + (V[{}] & 0xF) * 5;", x);
+		default:
+			// Control transfers resolved by the interpreter expect PC to point past the instruction.
+			if (is_terminator(instruction.op)) {
+				return std::format("r.PC = {:#05x}; context.interpret(context.chip8, {:#06x});", next, opcode);
+			}
+			return std::format("context.interpret(context.chip8, {:#06x});", opcode);
+		}
+	}
+
+	auto is_delay_wait(const Rom& rom, const uint16_t address) -> bool {
+		auto at = [&](const uint16_t pc) -> ks::Instruction {
+			return rom.contains(pc) ? ks::Chip8::decode(rom.opcode(pc)) : ks::Instruction{};
+		};
+		return ks::semantics::is_delay_wait(address, at(address), at((address + 2) & 0xFFF), at((address + 4) & 0xFFF));
+	}
+
+	auto build_block(const Rom& rom, const uint16_t address, std::set<uint16_t>& leaders) -> Block {
+		Block block{ .address = address };
+		std::ostringstream body;
+
+		uint16_t pc = address;
+		bool terminated = 0;
+		while (block.length < MAX_BLOCK_LENGTH && !terminated && rom.contains(pc)) {
+			// The emulator runs delay waits itself, so it can count the time spent in them.
+			if (block.length > 0 && is_delay_wait(rom, pc)) break;
+
+			const uint16_t opcode = rom.opcode(pc);
+			const ks::Instruction instruction = ks::Chip8::decode(opcode);
+			if (instruction.op == ks::Opcode::SET_VX_TO_DELAY ||
+				instruction.op == ks::Opcode::SET_DELAY_TO_VX ||
+				instruction.op == ks::Opcode::SET_SOUND_TO_VX)
+			{
+				block.timerIndex = block.length;
+			}
+			if (instruction.op == ks::Opcode::DRAW && block.drawIndex < 0) {
+				block.drawIndex = block.length;
+			}
+
+			const std::string statement = translate(rom, pc, instruction, opcode);
+			if (!statement.empty()) {
+				body << std::format("\t\t{}\t// {:03X}: {:04X}\n", statement, pc, opcode);
+			}
+
+			terminated = is_terminator(instruction.op);
+			block.length++;
+			pc = (pc + 2) & 0xFFF;
+		}
+		if (!terminated) {
+			body << std::format("\t\tr.PC = {:#05x};\n", pc);
+			// The interpreter should not have to walk the rest of a long straight run.
+			if (rom.contains(pc)) leaders.insert(pc);
+		}
+
+		block.body = body.str();
+		return block;
+	}
+
+	auto discover(const Rom& rom) -> std::map<uint16_t, Block> {
+		std::map<uint16_t, Block> blocks;
+		std::set<uint16_t> leaders{ PROGRAM_START };
+		std::set<uint16_t> visited;
+		std::vector<uint16_t> worklist{ PROGRAM_START };
+
+		// Walk every statically reachable instruction and start a block at every branch target.
+		while (!worklist.empty()) {
+			const uint16_t address = worklist.back();
+			worklist.pop_back();
+			if (!rom.contains(address) || !visited.insert(address).second) continue;
+
+			const ks::Instruction instruction = ks::Chip8::decode(rom.opcode(address));
+			for (const uint16_t successor : successors(rom, address, instruction)) {
+				if (is_terminator(instruction.op)) leaders.insert(successor);
+				worklist.push_back(successor);
+			}
+		}
+
+		while (!leaders.empty()) {
+			const uint16_t address = *leaders.begin();
+			leaders.erase(leaders.begin());
+			if (blocks.contains(address) || !rom.contains(address)) continue;
+			blocks[address] = build_block(rom, address, leaders);
+		}
+		return blocks;
+	}
+
+	auto generate(const Rom& rom, const std::string& name, const std::map<uint16_t, Block>& blocks) -> std::string {
+		std::ostringstream out;
+		out << std::format("// Generated by chip8-recomp from {}. Do not edit.\n\n", name);
+		out << "#include \"Chip8/Boot.hpp\"\n";
+		out << "#include \"Chip8/Recompiled.hpp\"\n\n";
+		out << "namespace {\n";
+		out << "\tusing ks::RecompiledContext;\n\n";
+
+		out << "\tconstexpr uint8_t ROM[] = {";
+		for (size_t i = 0; i < rom.bytes.size(); i++) {
+			out << (i % 16 == 0 ? "\n\t\t" : " ") << std::format("{:#04x},", rom.bytes[i]);
+		}
+		out << "\n\t};\n\n";
+
+		for (const auto& [address, block] : blocks) {
+			out << std::format("\tvoid block_{:03X}(RecompiledContext& context) {{\n", address);
+			out << "\t\t[[maybe_unused]] auto& r = context.cpu.registers;\n";
+			out << "\t\t[[maybe_unused]] auto& V = r.V;\n";
+			out << block.body;
+			out << "\t}\n";
+		}
+
+		out << "\n\tconstexpr ks::RecompiledBlock BLOCKS[] = {\n";
+		for (const auto& [address, block] : blocks) {
+			out << std::format("\t\t{{ {:#05x}, {}, {}, {}, &block_{:03X} }},\n", address, block.length, block.timerIndex, block.drawIndex, address);
+		}
+		out << "\t};\n\n";
+		// The boot sequence runs while this file compiles, loading the ROM copies the result.
+		out << "\tconstexpr ks::BootSnapshot BOOT = ks::boot(ROM);\n\n";
+		out << "\tconst bool registered = ks::register_recompiled_program({ ROM, BLOCKS, &BOOT });\n";
+		out << "}\n";
+		return out.str();
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		std::cerr << "Usage: chip8-recomp <rom.ch8> <output.cpp>\n";
+		return 1;
+	}
+
+	const fs::path input = argv[1];
+	std::ifstream file(input, std::ios::binary);
+	if (!file) {
+		std::cerr << std::format("Could not open {}\n", input.string());
+		return 1;
+	}
+
+	Rom rom{ std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {}) };
+	if (rom.bytes.empty() || rom.bytes.size() > ks::Chip8::RAM_SIZE - PROGRAM_START) {
+		std::cerr << std::format("{} is not a CHIP-8 ROM\n", input.string());
+		return 1;
+	}
+
+	const std::map<uint16_t, Block> blocks = discover(rom);
+
+	std::ofstream output(argv[2]);
+	if (!output) {
+		std::cerr << std::format("Could not write {}\n", argv[2]);
+		return 1;
+	}
+	output << generate(rom, input.filename().string(), blocks);
+	return 0;
+}
\ No newline at end of file